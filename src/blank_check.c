@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2026 McMCC <mcmcc@mail.ru>
+ * blank_check.c
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * All-0xFF detection for the write and erase skip paths. The kernel is
+ * picked once on first use: AVX2 or SSE2 on x86, NEON on ARM64, otherwise
+ * a word-wise scan. Every kernel ANDs whole vectors and tests only once per
+ * 64 bytes, so a page costs a few dozen instructions.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "blank_check.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BLANK_CHECK_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define BLANK_CHECK_NEON
+#endif
+
+/* The tail shorter than a vector goes through here */
+static int blank_bytes(const unsigned char *p, size_t len)
+{
+	unsigned char acc = 0xff;
+
+	while (len--)
+		acc &= *p++;
+	return acc == 0xff;
+}
+
+/* Words are loaded with memcpy, buf may be unaligned and of any type */
+static int blank_scalar(const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+	unsigned long w[4], acc = ~0UL;
+
+	for (; len >= sizeof(w); p += sizeof(w), len -= sizeof(w)) {
+		memcpy(w, p, sizeof(w));
+		acc &= w[0] & w[1] & w[2] & w[3];
+		if (acc != ~0UL)
+			return 0;
+	}
+
+	return blank_bytes(p, len);
+}
+
+#ifdef BLANK_CHECK_X86
+#if defined(__SSE2__)
+static int blank_sse2(const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+	const __m128i ones = _mm_set1_epi8((char)0xff);
+	__m128i acc;
+
+	for (; len >= 64; p += 64, len -= 64) {
+		acc = _mm_and_si128(_mm_and_si128(_mm_loadu_si128((const __m128i *)p),
+						  _mm_loadu_si128((const __m128i *)(p + 16))),
+				    _mm_and_si128(_mm_loadu_si128((const __m128i *)(p + 32)),
+						  _mm_loadu_si128((const __m128i *)(p + 48))));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, ones)) != 0xffff)
+			return 0;
+	}
+	for (; len >= 16; p += 16, len -= 16) {
+		acc = _mm_loadu_si128((const __m128i *)p);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, ones)) != 0xffff)
+			return 0;
+	}
+
+	return blank_bytes(p, len);
+}
+#endif
+
+__attribute__((target("avx2")))
+static int blank_avx2(const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+	const __m256i ones = _mm256_set1_epi8((char)0xff);
+	__m256i acc;
+
+	for (; len >= 128; p += 128, len -= 128) {
+		acc = _mm256_and_si256(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)p),
+							_mm256_loadu_si256((const __m256i *)(p + 32))),
+				       _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(p + 64)),
+							_mm256_loadu_si256((const __m256i *)(p + 96))));
+		if (!_mm256_testc_si256(acc, ones))
+			return 0;
+	}
+	for (; len >= 32; p += 32, len -= 32) {
+		acc = _mm256_loadu_si256((const __m256i *)p);
+		if (!_mm256_testc_si256(acc, ones))
+			return 0;
+	}
+
+	return blank_bytes(p, len);
+}
+#endif
+
+#ifdef BLANK_CHECK_NEON
+static int blank_neon(const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+	uint8x16_t acc;
+
+	for (; len >= 64; p += 64, len -= 64) {
+		acc = vandq_u8(vandq_u8(vld1q_u8(p), vld1q_u8(p + 16)),
+			       vandq_u8(vld1q_u8(p + 32), vld1q_u8(p + 48)));
+		if (vminvq_u8(acc) != 0xff)
+			return 0;
+	}
+	for (; len >= 16; p += 16, len -= 16) {
+		if (vminvq_u8(vld1q_u8(p)) != 0xff)
+			return 0;
+	}
+
+	return blank_bytes(p, len);
+}
+#endif
+
+static int blank_dispatch(const void *buf, size_t len);
+
+static int (*blank_kernel)(const void *buf, size_t len) = blank_dispatch;
+static const char *blank_kernel_name = "scalar";
+
+static void blank_select(void)
+{
+	blank_kernel = blank_scalar;
+	blank_kernel_name = "scalar";
+#ifdef BLANK_CHECK_X86
+#if defined(__SSE2__)
+	blank_kernel = blank_sse2;
+	blank_kernel_name = "sse2";
+#endif
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		blank_kernel = blank_avx2;
+		blank_kernel_name = "avx2";
+	}
+#endif
+#ifdef BLANK_CHECK_NEON
+	blank_kernel = blank_neon;
+	blank_kernel_name = "neon";
+#endif
+}
+
+static int blank_dispatch(const void *buf, size_t len)
+{
+	blank_select();
+	return blank_kernel(buf, len);
+}
+
+int mem_is_blank(const void *buf, size_t len)
+{
+	return blank_kernel(buf, len);
+}
+
+const char *mem_is_blank_impl(void)
+{
+	if (blank_kernel == blank_dispatch)
+		blank_select();
+	return blank_kernel_name;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2026 McMCC <mcmcc@mail.ru>
+ * blank_check.h
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef __BLANK_CHECK_H__
+#define __BLANK_CHECK_H__
+
+#include <stddef.h>
+
+/* Returns 1 if all len bytes of buf are 0xFF (erased flash), 0 otherwise */
+int mem_is_blank(const void *buf, size_t len);
+
+/* Name of the kernel picked for this CPU */
+const char *mem_is_blank_impl(void);
+
+#endif /* __BLANK_CHECK_H__ */
+/* End of [blank_check.h] package */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 McMCC <mcmcc@mail.ru>
+ * blank_check_bench.c
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Microbenchmark for mem_is_blank(), built with "make bench". Compares the
+ * selected kernel with a byte loop on the buffer sizes the write paths use.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "blank_check.h"
+
+static int byte_loop(const unsigned char *p, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		if (p[i] != 0xff)
+			return 0;
+	return 1;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(void)
+{
+	static const size_t sizes[] = { 128, 256, 2048 + 64, 4096 + 256, 128 * 1024 };
+	unsigned char *buf;
+	volatile int sink = 0;
+	size_t i, s, iters;
+	double t0, t1, t2;
+
+	buf = malloc(128 * 1024 + 1);
+	if (!buf)
+		return 1;
+	/* Start one byte off to catch unaligned loads */
+	memset(buf, 0xff, 128 * 1024 + 1);
+
+	printf("kernel: %s\n", mem_is_blank_impl());
+	printf("%10s %14s %14s\n", "bytes", "byte loop GB/s", "kernel GB/s");
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		iters = (256UL * 1024 * 1024) / sizes[s];
+
+		t0 = now();
+		for (i = 0; i < iters; i++)
+			sink += byte_loop(buf + 1, sizes[s]);
+		t1 = now();
+		for (i = 0; i < iters; i++)
+			sink += mem_is_blank(buf + 1, sizes[s]);
+		t2 = now();
+
+		printf("%10zu %14.2f %14.2f\n", sizes[s],
+		       iters * sizes[s] / (t1 - t0) / 1e9,
+		       iters * sizes[s] / (t2 - t1) / 1e9);
+	}
+
+	/* Sanity: a single cleared bit anywhere must be found */
+	for (i = 0; i < 4096 + 256; i++) {
+		buf[1 + i] = 0xfe;
+		if (mem_is_blank(buf + 1, 4096 + 256)) {
+			printf("FAIL: missed byte %zu\n", i);
+			return 1;
+		}
+		buf[1 + i] = 0xff;
+	}
+	printf("check: ok (%d)\n", sink != 0);
+
+	free(buf);
+	return 0;
+}
@@ -23,6 +23,7 @@
  */
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "ch341a_spi.h"
 #include <libusb-1.0/libusb.h>
 #include <stdbool.h>
@@ -380,6 +381,214 @@ static int ch341a_spi_send_command(unsigned int writecnt, unsigned int readcnt,
 	return 0;
 }
 
+/* One USB packet of a batch: a CS toggle or up to 31 bytes of SPI stream */
+struct ch341a_packet {
+	uint8_t buf[CH341_PACKET_LENGTH];
+	unsigned int len;	/* bytes sent */
+	unsigned int reply;	/* bytes the CH341A sends back for it */
+};
+
+/* Deselect the chip, then select it again: ends one transaction and starts the next */
+static void ch341a_cs_packet(struct ch341a_packet *pkt)
+{
+	uint8_t *ptr = pkt->buf;
+
+	*ptr++ = CH341A_CMD_UIO_STREAM;
+	*ptr++ = CH341A_CMD_UIO_STM_OUT | 0x37; // CS high (all of them), SCK=0, DOUT*=1
+	*ptr++ = CH341A_CMD_UIO_STM_OUT | 0x37; // CS high (all of them), SCK=0, DOUT*=1
+	*ptr++ = CH341A_CMD_UIO_STM_OUT | 0x36; // CS low (all of them), SCK=0, DOUT*=1
+	*ptr++ = CH341A_CMD_UIO_STM_END;
+	pkt->len = ptr - pkt->buf;
+	pkt->reply = 0;
+}
+
+/*
+ * Queue every packet of a batch as its own OUT transfer, so CS toggles and
+ * SPI stream packets shorter than 32 bytes keep their boundaries, and
+ * collect the replies in order. The whole batch goes out in one go instead
+ * of one USB round trip per transaction.
+ */
+static int32_t usb_transfer_batch(const char *func, const struct ch341a_packet *pkts, unsigned int npkts, uint8_t *readarr)
+{
+	struct libusb_transfer **outs;
+	int *state_out;
+	int state_in[USB_IN_TRANSFERS] = {0};
+	unsigned int i, out_done = 0, next_in = 0, free_idx = 0, in_idx = 0, in_active = 0;
+	unsigned int expect[USB_IN_TRANSFERS];
+	uint8_t *in_buf = readarr;
+	int32_t ret = 0;
+
+	if (handle == NULL)
+		return -1;
+
+	outs = calloc(npkts, sizeof(*outs));
+	state_out = calloc(npkts, sizeof(*state_out));
+	if (!outs || !state_out) {
+		free(outs);
+		free(state_out);
+		return -1;
+	}
+
+	for (i = 0; i < npkts; i++) {
+		outs[i] = libusb_alloc_transfer(0);
+		if (!outs[i]) {
+			printf("%s: failed to alloc OUT transfer\n", func);
+			ret = -1;
+			goto err;
+		}
+		libusb_fill_bulk_transfer(outs[i], handle, WRITE_EP, (uint8_t *)pkts[i].buf, pkts[i].len,
+				cb_out, &state_out[i], USB_TIMEOUT);
+		state_out[i] = TRANS_ACTIVE;
+		if (libusb_submit_transfer(outs[i])) {
+			printf("%s: failed to submit OUT transfer\n", func);
+			state_out[i] = TRANS_ERR;
+			ret = -1;
+			goto err;
+		}
+	}
+
+	do {
+		/* Schedule one read per packet that answers, while transfers are free */
+		while (next_in < npkts && state_in[free_idx] == TRANS_IDLE) {
+			if (!pkts[next_in].reply) {
+				next_in++;
+				continue;
+			}
+			expect[free_idx] = pkts[next_in].reply;
+			transfer_ins[free_idx]->length = pkts[next_in].reply;
+			transfer_ins[free_idx]->buffer = in_buf;
+			transfer_ins[free_idx]->user_data = &state_in[free_idx];
+			if (libusb_submit_transfer(transfer_ins[free_idx])) {
+				printf("%s: failed to submit IN transfer\n", func);
+				ret = -1;
+				goto err;
+			}
+			in_buf += pkts[next_in].reply;
+			state_in[free_idx] = TRANS_ACTIVE;
+			in_active++;
+			free_idx = (free_idx + 1) % USB_IN_TRANSFERS;
+			next_in++;
+		}
+
+		libusb_handle_events_timeout(NULL, &(struct timeval){1, 0});
+
+		for (; out_done < npkts && state_out[out_done] != TRANS_ACTIVE; out_done++) {
+			if (state_out[out_done] == TRANS_ERR) {
+				ret = -1;
+				goto err;
+			}
+		}
+		while (state_in[in_idx] != TRANS_IDLE && state_in[in_idx] != TRANS_ACTIVE) {
+			if (state_in[in_idx] != expect[in_idx]) {
+				ret = -1;
+				goto err;
+			}
+			state_in[in_idx] = TRANS_IDLE;
+			in_active--;
+			in_idx = (in_idx + 1) % USB_IN_TRANSFERS;
+		}
+	} while (out_done < npkts || next_in < npkts || in_active);
+
+err:
+	if (ret) {
+		printf("%s: Failed to run a batch of %u packets\n", func, npkts);
+		/* Cancel whatever is still queued and wait for it to finish */
+		for (i = 0; i < npkts && outs[i]; i++)
+			if (state_out[i] == TRANS_ACTIVE && libusb_cancel_transfer(outs[i]))
+				state_out[i] = TRANS_ERR;
+		for (i = 0; i < USB_IN_TRANSFERS; i++)
+			if (state_in[i] == TRANS_ACTIVE && libusb_cancel_transfer(transfer_ins[i]))
+				state_in[i] = TRANS_ERR;
+		while (1) {
+			bool finished = true;
+			for (i = 0; i < npkts && outs[i]; i++)
+				if (state_out[i] == TRANS_ACTIVE)
+					finished = false;
+			for (i = 0; i < USB_IN_TRANSFERS; i++)
+				if (state_in[i] == TRANS_ACTIVE)
+					finished = false;
+			if (finished)
+				break;
+			libusb_handle_events_timeout(NULL, &(struct timeval){1, 0});
+		}
+	}
+	for (i = 0; i < npkts && outs[i]; i++)
+		libusb_free_transfer(outs[i]);
+	free(outs);
+	free(state_out);
+
+	return ret;
+}
+
+/*
+ * Run several transactions in one USB submission. Each one is framed by a
+ * CS toggle packet, and the chip is left selected afterwards with a fresh
+ * toggle, the same state enable_pins() leaves it in.
+ */
+static int ch341a_spi_send_batch(const struct spi_transfer *xfers, unsigned int count)
+{
+	struct ch341a_packet *pkts, *pkt;
+	unsigned int i, npkts = 1, total = 0, off, n, write_left, read_left;
+	uint8_t *rbuf, *rpos;
+	const uint8_t *wpos;
+	int ret;
+
+	for (i = 0; i < count; i++) {
+		npkts += 1 + (xfers[i].writecnt + xfers[i].readcnt + CH341_PACKET_LENGTH - 2) / (CH341_PACKET_LENGTH - 1);
+		total += xfers[i].writecnt + xfers[i].readcnt;
+	}
+
+	pkts = malloc(npkts * sizeof(*pkts));
+	rbuf = malloc(total ? total : 1);
+	if (!pkts || !rbuf) {
+		free(pkts);
+		free(rbuf);
+		return -1;
+	}
+
+	pkt = pkts;
+	for (i = 0; i < count; i++) {
+		ch341a_cs_packet(pkt++);
+		wpos = xfers[i].writearr;
+		write_left = xfers[i].writecnt;
+		read_left = xfers[i].readcnt;
+		while (write_left || read_left) {
+			uint8_t *ptr = pkt->buf;
+
+			*ptr++ = CH341A_CMD_SPI_STREAM;
+			n = min(CH341_PACKET_LENGTH - 1, write_left);
+			for (off = 0; off < n; off++)
+				*ptr++ = swap_byte(*wpos++);
+			write_left -= n;
+			off = min((CH341_PACKET_LENGTH - 1) - n, read_left);
+			memset(ptr, 0xFF, off);
+			ptr += off;
+			read_left -= off;
+			pkt->len = ptr - pkt->buf;
+			pkt->reply = pkt->len - 1;
+			pkt++;
+		}
+	}
+	ch341a_cs_packet(pkt++);
+
+	ret = usb_transfer_batch(__func__, pkts, pkt - pkts, rbuf);
+
+	/* Every clocked byte comes back, keep the ones after each write phase */
+	if (!ret) {
+		rpos = rbuf;
+		for (i = 0; i < count; i++) {
+			rpos += xfers[i].writecnt;
+			for (off = 0; off < xfers[i].readcnt; off++)
+				xfers[i].readarr[off] = swap_byte(*rpos++);
+		}
+	}
+
+	free(pkts);
+	free(rbuf);
+
+	return ret;
+}
+
 int ch341a_spi_shutdown(void)
 {
 	if (handle == NULL)
@@ -508,6 +717,7 @@ const struct spi_controller ch341a_spictrl = {
 	.init = ch341a_spi_init,
 	.shutdown = ch341a_spi_shutdown,
 	.send_command = ch341a_spi_send_command,
+	.send_batch = ch341a_spi_send_batch,
 };
 
 /* End of [ch341a_spi.c] package */
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2026 McMCC <mcmcc@mail.ru>
+ * flash_state.c
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Chips that are flashed over and over keep a record of what was last
+ * written to them: one hash per erase block, in <dir>/<unique id>.state.
+ * A write then only has to touch the blocks whose hash changed, without
+ * reading the chip first. A hash of zero means the block is unknown.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "flash_state.h"
+
+#define STATE_MAGIC	"SNDSTAT1"
+
+struct state_header {
+	char			magic[8];
+	unsigned long long	size;
+	unsigned int		block;
+	unsigned int		count;
+};
+
+static struct {
+	char			*path;
+	struct state_header	hdr;
+	uint64_t		*hash;
+	uint64_t		blank;
+} state;
+
+/* FNV-1a, never 0 */
+static uint64_t state_hash(const unsigned char *data, unsigned int len)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	unsigned int i;
+
+	for (i = 0; i < len; i++) {
+		h ^= data[i];
+		h *= 0x100000001b3ULL;
+	}
+
+	return h ? h : 1;
+}
+
+static void state_free(void)
+{
+	free(state.path);
+	free(state.hash);
+	state.path = NULL;
+	state.hash = NULL;
+}
+
+int flash_state_open(const char *dir, const unsigned char *uid, int uid_len,
+		unsigned long long size, unsigned int block)
+{
+	struct state_header hdr;
+	unsigned char *ff;
+	FILE *fp;
+	char *p;
+	int i;
+
+	if (!block || size % block)
+		return -1;
+
+	state.path = malloc(strlen(dir) + 2 * uid_len + sizeof("/.state"));
+	ff = malloc(block);
+	memset(&state.hdr, 0, sizeof(state.hdr));
+	memcpy(state.hdr.magic, STATE_MAGIC, sizeof(state.hdr.magic));
+	state.hdr.size = size;
+	state.hdr.block = block;
+	state.hdr.count = size / block;
+	state.hash = calloc(state.hdr.count, sizeof(*state.hash));
+	if (!state.path || !ff || !state.hash) {
+		printf("Malloc failed for chip state.\n");
+		free(ff);
+		state_free();
+		return -1;
+	}
+
+	memset(ff, 0xff, block);
+	state.blank = state_hash(ff, block);
+	free(ff);
+
+	p = state.path + sprintf(state.path, "%s/", dir);
+	for (i = 0; i < uid_len; i++)
+		p += sprintf(p, "%02x", uid[i]);
+	strcpy(p, ".state");
+
+	fp = fopen(state.path, "rb");
+	if (fp) {
+		if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || memcmp(&hdr, &state.hdr, sizeof(hdr)) ||
+		    fread(state.hash, sizeof(*state.hash), state.hdr.count, fp) != state.hdr.count) {
+			printf("Chip state %s does not match this chip, starting over\n", state.path);
+			memset(state.hash, 0, state.hdr.count * sizeof(*state.hash));
+		}
+		fclose(fp);
+	}
+
+	printf("Chip state: %s\n", state.path);
+
+	return 0;
+}
+
+int flash_state_active(void)
+{
+	return state.hash != NULL;
+}
+
+static unsigned int state_index(unsigned long long addr)
+{
+	return addr / state.hdr.block;
+}
+
+int flash_state_same(unsigned long long addr, const unsigned char *data)
+{
+	uint64_t h = state.hash[state_index(addr)];
+
+	return h && h == state_hash(data, state.hdr.block);
+}
+
+void flash_state_set(unsigned long long addr, const unsigned char *data)
+{
+	state.hash[state_index(addr)] = state_hash(data, state.hdr.block);
+}
+
+static void state_fill(uint64_t *hash, unsigned long long addr, unsigned long long len, uint64_t whole)
+{
+	unsigned long long end = addr + len;
+	unsigned int i;
+
+	for (i = state_index(addr); i < state.hdr.count && (unsigned long long)i * state.hdr.block < end; i++) {
+		unsigned long long start = (unsigned long long)i * state.hdr.block;
+
+		if (start >= addr && start + state.hdr.block <= end)
+			hash[i] = whole;
+		else
+			hash[i] = 0;
+	}
+}
+
+static int state_save(const uint64_t *hash)
+{
+	FILE *fp;
+	int ret = 0;
+
+	fp = fopen(state.path, "wb");
+	if (!fp || fwrite(&state.hdr, sizeof(state.hdr), 1, fp) != 1 ||
+	    fwrite(hash, sizeof(*hash), state.hdr.count, fp) != state.hdr.count) {
+		printf("Couldn't save chip state %s.\n", state.path);
+		ret = -1;
+	}
+	if (fp && fclose(fp))
+		ret = -1;
+
+	return ret;
+}
+
+int flash_state_begin(unsigned long long addr, unsigned long long len)
+{
+	uint64_t *hash;
+	int ret;
+
+	if (!state.hash)
+		return 0;
+
+	hash = malloc(state.hdr.count * sizeof(*hash));
+	if (!hash) {
+		printf("Malloc failed for chip state.\n");
+		return -1;
+	}
+	memcpy(hash, state.hash, state.hdr.count * sizeof(*hash));
+	state_fill(hash, addr, len, 0);
+	ret = state_save(hash);
+	free(hash);
+
+	return ret;
+}
+
+void flash_state_set_blank(unsigned long long addr, unsigned long long len)
+{
+	if (state.hash)
+		state_fill(state.hash, addr, len, state.blank);
+}
+
+void flash_state_forget(unsigned long long addr, unsigned long long len)
+{
+	if (state.hash)
+		state_fill(state.hash, addr, len, 0);
+}
+
+int flash_state_close(void)
+{
+	int ret = 0;
+
+	if (state.hash && state.path)
+		ret = state_save(state.hash);
+
+	state_free();
+
+	return ret;
+}
+/* End of [flash_state.c] package */
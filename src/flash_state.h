@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 McMCC <mcmcc@mail.ru>
+ * flash_state.h
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef __FLASH_STATE_H__
+#define __FLASH_STATE_H__
+
+/* Load the block hashes recorded for the chip with this unique ID from dir */
+int flash_state_open(const char *dir, const unsigned char *uid, int uid_len,
+		unsigned long long size, unsigned int block);
+int flash_state_active(void);
+
+/* addr is block aligned and data one whole block */
+int flash_state_same(unsigned long long addr, const unsigned char *data);
+void flash_state_set(unsigned long long addr, const unsigned char *data);
+
+/*
+ * Call before touching the chip: the range is saved as unknown, so a run
+ * that dies halfway never leaves stale hashes behind. The new hashes only
+ * reach the file with flash_state_close().
+ */
+int flash_state_begin(unsigned long long addr, unsigned long long len);
+
+/* Whole blocks inside the range become blank, partly covered ones unknown */
+void flash_state_set_blank(unsigned long long addr, unsigned long long len);
+void flash_state_forget(unsigned long long addr, unsigned long long len);
+
+/* Save the hashes back and drop them */
+int flash_state_close(void);
+
+#endif /* __FLASH_STATE_H__ */
+/* End of [flash_state.h] package */
@@ -14,34 +14,68 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "flashcmd_api.h"
+#include "spi_controller.h"
 
 #ifdef EEPROM_SUPPORT
 #define __EEPROM___	"or EEPROM"
 extern int eepromsize;
 extern int mw_eepromsize;
+extern int spi_eepromsize;
 #else
 #define __EEPROM___	""
 #endif
 
-long flash_cmd_init(struct flash_cmd *cmd)
+struct flash_id flash_probe_id;
+int flash_erase_skip_blank = 0;
+
+/*
+ * One RDID is enough to identify every supported chip: SPI NOR and SPI NAND
+ * without a dummy byte return the IDs from the first byte on, SPI NAND with
+ * an address/dummy byte (most vendors, Toshiba/KIOXIA) from the second one.
+ */
+int flash_read_id(struct flash_id *id)
+{
+	int ret;
+
+	memset(id, 0, sizeof(*id));
+
+	SPI_CONTROLLER_Chip_Select_Low();
+	SPI_CONTROLLER_Write_One_Byte(0x9F);
+	ret = SPI_CONTROLLER_Read_NByte(id->raw, FLASH_ID_LEN, SPI_CONTROLLER_SPEED_SINGLE);
+	SPI_CONTROLLER_Chip_Select_High();
+
+	if (ret) {
+		printf("%s: ret: %x\n", __func__, ret);
+		return ret;
+	}
+
+	id->valid = 1;
+	return 0;
+}
+
+long long flash_cmd_init(struct flash_cmd *cmd)
 {
-	long flen = -1;
+	long long flen = -1;
 
 #ifdef EEPROM_SUPPORT
-	if ((eepromsize <= 0) && (mw_eepromsize <= 0)) {
+	if ((eepromsize <= 0) && (mw_eepromsize <= 0) && (spi_eepromsize <= 0)) {
 #endif
+		flash_read_id(&flash_probe_id);
 		if ((flen = snand_init()) > 0) {
 			cmd->flash_erase = snand_erase;
 			cmd->flash_write = snand_write;
 			cmd->flash_read  = snand_read;
+			cmd->flash_uid   = snand_read_uid;
 		} else if ((flen = snor_init()) > 0) {
 			cmd->flash_erase = snor_erase;
 			cmd->flash_write = snor_write;
 			cmd->flash_read  = snor_read;
+			cmd->flash_uid   = snor_read_uid;
 		}
 #ifdef EEPROM_SUPPORT
-	} else if ((eepromsize > 0) || (mw_eepromsize > 0)) {
+	} else if ((eepromsize > 0) || (mw_eepromsize > 0) || (spi_eepromsize > 0)) {
 		if ((eepromsize > 0) && (flen = i2c_init()) > 0) {
 			cmd->flash_erase = i2c_eeprom_erase;
 			cmd->flash_write = i2c_eeprom_write;
@@ -50,6 +84,10 @@ long flash_cmd_init(struct flash_cmd *cmd)
 			cmd->flash_erase = mw_eeprom_erase;
 			cmd->flash_write = mw_eeprom_write;
 			cmd->flash_read  = mw_eeprom_read;
+		} else if ((spi_eepromsize > 0) && (flen = spi_eeprom_init()) > 0) {
+			cmd->flash_erase = spi_eeprom_erase;
+			cmd->flash_write = spi_eeprom_write;
+			cmd->flash_read  = spi_eeprom_read;
 		}
 	}
 #endif
@@ -69,6 +107,8 @@ void support_flash_list(void)
 	support_i2c_eeprom_list();
 	printf("\n");
 	support_mw_eeprom_list();
+	printf("\n");
+	support_spi_eeprom_list();
 #endif
 }
 /* End of [flashcmd.c] package */
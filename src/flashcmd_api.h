@@ -20,15 +20,32 @@
 #ifdef EEPROM_SUPPORT
 #include "i2c_eeprom_api.h"
 #include "mw_eeprom_api.h"
+#include "spi_eeprom_api.h"
 #endif
 
 struct flash_cmd {
-	int (*flash_read)(unsigned char *buf, unsigned long from, unsigned long len);
-	int (*flash_erase)(unsigned long offs, unsigned long len);
-	int (*flash_write)(unsigned char *buf, unsigned long to, unsigned long len);
+	long long (*flash_read)(unsigned char *buf, unsigned long long from, unsigned long long len);
+	int (*flash_erase)(unsigned long long offs, unsigned long long len);
+	long long (*flash_write)(unsigned char *buf, unsigned long long to, unsigned long long len);
+	/* optional, factory unique ID; returns its length or -1 */
+	int (*flash_uid)(unsigned char *uid, int len);
 };
 
-long flash_cmd_init(struct flash_cmd *cmd);
+#define FLASH_ID_LEN		5
+
+/* Bytes clocked out after one RDID (0x9F), shared by the NAND and NOR probe */
+struct flash_id {
+	unsigned char	raw[FLASH_ID_LEN];
+	int		valid;
+};
+
+extern struct flash_id flash_probe_id;
+
+/* Check each erase block first and leave it alone if it is already blank */
+extern int flash_erase_skip_blank;
+
+int flash_read_id(struct flash_id *id);
+long long flash_cmd_init(struct flash_cmd *cmd);
 void support_flash_list(void);
 
 #endif /* __FLASHCMD_API_H__ */
@@ -22,7 +22,7 @@ struct EEPROM eeprom_info;
 char eepromname[12];
 int eepromsize = 0;
 
-int i2c_eeprom_read(unsigned char *buf, unsigned long from, unsigned long len)
+long long i2c_eeprom_read(unsigned char *buf, unsigned long long from, unsigned long long len)
 {
 	unsigned char *pbuf, ebuf[MAX_EEPROM_SIZE];
 
@@ -34,19 +34,19 @@ int i2c_eeprom_read(unsigned char *buf, unsigned long from, unsigned long len)
 	pbuf = ebuf;
 
 	if (ch341readEEPROM(pbuf, eepromsize, &eeprom_info) < 0) {
-		printf("Couldnt read [%d] bytes from [%s] EEPROM address 0x%08lu\n", (int)len, eepromname, from);
+		printf("Couldnt read [%d] bytes from [%s] EEPROM address 0x%08llu\n", (int)len, eepromname, from);
 		return -1;
 	}
 
 	memcpy(buf, pbuf + from, len);
 
-	printf("Read [%d] bytes from [%s] EEPROM address 0x%08lu\n", (int)len, eepromname, from);
+	printf("Read [%d] bytes from [%s] EEPROM address 0x%08llu\n", (int)len, eepromname, from);
 	timer_end();
 
-	return (int)len;
+	return (long long)len;
 }
 
-int i2c_eeprom_erase(unsigned long offs, unsigned long len)
+int i2c_eeprom_erase(unsigned long long offs, unsigned long long len)
 {
 	unsigned char *pbuf, ebuf[MAX_EEPROM_SIZE];
 
@@ -66,17 +66,17 @@ int i2c_eeprom_erase(unsigned long offs, unsigned long len)
 	}
 
 	if(ch341writeEEPROM(pbuf, eepromsize, &eeprom_info) < 0) {
-		printf("Failed to erase [%d] bytes of [%s] EEPROM address 0x%08lu\n", (int)len, eepromname, offs);
+		printf("Failed to erase [%d] bytes of [%s] EEPROM address 0x%08llu\n", (int)len, eepromname, offs);
 		return -1;
 	}
 
-	printf("Erased [%d] bytes of [%s] EEPROM address 0x%08lu\n", (int)len, eepromname, offs);
+	printf("Erased [%d] bytes of [%s] EEPROM address 0x%08llu\n", (int)len, eepromname, offs);
 	timer_end();
 
 	return 0;
 }
 
-int i2c_eeprom_write(unsigned char *buf, unsigned long to, unsigned long len)
+long long i2c_eeprom_write(unsigned char *buf, unsigned long long to, unsigned long long len)
 {
 	unsigned char *pbuf, ebuf[MAX_EEPROM_SIZE];
 
@@ -96,17 +96,17 @@ int i2c_eeprom_write(unsigned char *buf, unsigned long to, unsigned long len)
 	memcpy(pbuf + to, buf, len);
 
 	if(ch341writeEEPROM(pbuf, eepromsize, &eeprom_info) < 0) {
-		printf("Failed to write [%d] bytes of [%s] EEPROM address 0x%08lu\n", (int)len, eepromname, to);
+		printf("Failed to write [%d] bytes of [%s] EEPROM address 0x%08llu\n", (int)len, eepromname, to);
 		return -1;
 	}
 
-	printf("Wrote [%d] bytes to [%s] EEPROM address 0x%08lu\n", (int)len, eepromname, to);
+	printf("Wrote [%d] bytes to [%s] EEPROM address 0x%08llu\n", (int)len, eepromname, to);
 	timer_end();
 
-	return (int)len;
+	return (long long)len;
 }
 
-long i2c_init(void)
+long long i2c_init(void)
 {
 	if (config_stream(CH341_I2C_STANDARD_SPEED) < 0)
 		return -1;
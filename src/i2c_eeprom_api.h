@@ -15,10 +15,10 @@
 #ifndef __I2C_EEPROM_API_H__
 #define __I2C_EEPROM_API_H__
 
-int i2c_eeprom_read(unsigned char *buf, unsigned long from, unsigned long len);
-int i2c_eeprom_erase(unsigned long offs, unsigned long len);
-int i2c_eeprom_write(unsigned char *buf, unsigned long to, unsigned long len);
-long i2c_init(void);
+long long i2c_eeprom_read(unsigned char *buf, unsigned long long from, unsigned long long len);
+int i2c_eeprom_erase(unsigned long long offs, unsigned long long len);
+long long i2c_eeprom_write(unsigned char *buf, unsigned long long to, unsigned long long len);
+long long i2c_init(void);
 void support_i2c_eeprom_list(void);
 
 #endif /* __I2C_EEPROM_API_H__ */
@@ -29,6 +29,8 @@
 #include "flashcmd_api.h"
 #include "spi_controller.h"
 #include "spi_nand_flash.h"
+#include "nand_split.h"
+#include "flash_state.h"
 
 struct flash_cmd prog;
 extern unsigned int bsize;
@@ -45,9 +47,11 @@ extern struct EEPROM eeprom_info;
 extern char eepromname[12];
 extern int eepromsize;
 extern int mw_eepromsize;
+extern int spi_eepromsize;
 extern int org;
 #define EHELP	" -E             select I2C EEPROM {24c01|24c02|24c04|24c08|24c16|24c32|24c64|24c128|24c256|24c512|24c1024}\n" \
 		"                select Microwire EEPROM {93c06|93c16|93c46|93c56|93c66|93c76|93c86|93c96} (need SPI-to-MW adapter)\n" \
+		"                select SPI EEPROM {25c010|25c020|25c040|25c080|25c160|25c320|25c640|25c128|25c256|25c512|25c1024|25m02}\n" \
 		" -8             set organization 8-bit for Microwire EEPROM(default 16-bit) and set jumper on SPI-to-MW adapter\n" \
 		" -f <addr len>  set manual address size in bits for Microwire EEPROM(default auto)\n"
 #else
@@ -73,40 +77,276 @@ void usage(void)
 		" -p             programmer {ch341a|mstarddc} (default ch341a)\n"\
 		" -c             programmer connection string\n"\
 		" -d             disable internal ECC(use read and write page size + OOB size)\n"\
+		" -s             with -d, read/write <filename>.data and <filename>.oob instead of one raw image\n"\
+		" -P             program two blocks on different planes at once (SPI NAND with two planes)\n"\
+		" -u             partial page program, send only the bytes that are not 0xFF (SPI NAND, with -d)\n"\
+		" -B[percent]    use MediaTek BMT, pool in the last percent of blocks (default 7)\n"\
 		" -I             ECC ignore errors(for read test only)\n"\
 		" -L             print list support chips\n"\
 		" -i             read the chip ID info\n"\
+		" -g             run an unknown SPI NOR Flash with a generic profile sized from its ID\n"\
 		"" EHELP ""\
 		" -e             erase chip(full or use with -a [-l])\n"\
+		" -b             with -e, skip blocks that are already blank\n"\
+		" -k             with -e, erase any range and keep the data around it (SPI NOR)\n"\
 		" -l <bytes>     manually set length\n"\
 		" -a <address>   manually set address\n"\
+		" -m <address>   move blocks from -a [-l] to address inside SPI NAND chip\n"\
 		" -w <filename>  write chip with data from filename\n"\
 		" -r <filename>  read chip and save data to filename\n"\
-		" -v             verify after write on chip\n";
+		" -v             verify after write on chip\n"\
+		" -U             with -w, reflash only the sectors that differ, no prior erase needed (SPI NOR)\n"\
+		" -C <dir>       keep per-block hashes of each chip (by unique ID) in dir, write only changed blocks\n"\
+		" -S <percent>   with -C, read back this share of the unchanged blocks to catch outside changes\n";
 	printf(use);
 	exit(0);
 }
 
 const struct spi_controller *spi_controller;
 
-int main(int argc, char* argv[])
+/* Large parts (and raw NAND with OOB) do not fit in memory in one go, so
+ * plain reads and writes stream the file through a bounded buffer. */
+#define RW_CHUNK_SIZE	(64 * 1024 * 1024)
+
+static unsigned long long rw_chunk_size(void)
+{
+	if (bsize && bsize < RW_CHUNK_SIZE)
+		return RW_CHUNK_SIZE - (RW_CHUNK_SIZE % bsize);
+	return RW_CHUNK_SIZE;
+}
+
+static unsigned char *rw_chunk_alloc(unsigned long long len, unsigned long long *chunk)
 {
-	int c, vr = 0, svr = 0, ret = 0, i;
-	char *str, *fname = NULL, op = 0;
 	unsigned char *buf;
-	int long long len = 0, addr = 0, flen = 0, wlen = 0;
+
+	*chunk = rw_chunk_size();
+	if (len < *chunk)
+		*chunk = len;
+	buf = (unsigned char *)malloc(*chunk + 1);
+	if (!buf)
+		printf("Malloc failed for read buffer.\n");
+	return buf;
+}
+
+static int read_to_file(FILE *fp, unsigned long long addr, unsigned long long len)
+{
+	unsigned long long chunk, done, n;
+	unsigned char *buf;
+	long long ret = 0;
+
+	if (!(buf = rw_chunk_alloc(len, &chunk)))
+		return -1;
+	for (done = 0; done < len; done += n) {
+		n = min(chunk, len - done);
+		ret = prog.flash_read(buf, addr + done, n);
+		if (ret < 0) {
+			printf("Status: BAD(%lld)\n", ret);
+			break;
+		}
+		if (fwrite(buf, 1, n, fp) != n) {
+			printf("Error writing file\n");
+			ret = -1;
+			break;
+		}
+	}
+	free(buf);
+	return ret < 0 ? -1 : 0;
+}
+
+static int state_spot_check = 0;
+static unsigned int state_written = 0, state_unchanged = 0;
+
+/* -C: load the block hashes last written to this very chip */
+static void state_init(const char *dir, unsigned long long flen, unsigned long long addr)
+{
+	unsigned char uid[16];
+	int n;
+
+	if (!prog.flash_uid || (n = prog.flash_uid(uid, sizeof(uid))) <= 0) {
+		printf("Chip has no readable unique ID, -C ignored\n");
+		return;
+	}
+	if (addr % bsize) {
+		printf("Address is not block aligned, -C ignored\n");
+		return;
+	}
+	flash_state_open(dir, uid, n, flen, bsize);
+}
+
+/* Read a block the state says is unchanged, returns non-zero if it is not */
+static int state_spot_check_failed(unsigned char *data, unsigned long long addr)
+{
+	unsigned char *tmp;
+	int failed;
+
+	if (!state_spot_check || rand() % 100 >= state_spot_check)
+		return 0;
+	if (!(tmp = (unsigned char *)malloc(bsize)))
+		return 1;
+	failed = prog.flash_read(tmp, addr, bsize) < 0 || memcmp(tmp, data, bsize);
+	free(tmp);
+	if (failed)
+		printf("Block at 0x%016llX was changed outside SNANDer, writing it again\n", addr);
+
+	return failed;
+}
+
+/*
+ * Erase and write one run of changed blocks and record their new hashes.
+ * A partial last block is merged into what the chip holds there, so the
+ * erase always takes whole blocks and nothing is programmed twice.
+ */
+static int state_write_run(unsigned char *buf, unsigned long long addr, unsigned long long len)
+{
+	unsigned long long whole = len - len % bsize, pos;
+	unsigned char *tail = NULL;
+
+	if (!len)
+		return 0;
+
+	if (whole < len) {
+		if (!(tail = (unsigned char *)malloc(bsize))) {
+			printf("Malloc failed for block buffer.\n");
+			goto fail;
+		}
+		if (prog.flash_read(tail, addr + whole, bsize) < 0)
+			goto fail;
+		memcpy(tail, buf + whole, len - whole);
+	}
+
+	/* the incremental NOR writer erases only where it has to */
+	if (!(prog.flash_write == snor_write && snor_write_incremental) &&
+	    prog.flash_erase(addr, whole + (tail ? bsize : 0)))
+		goto fail;
+	if (whole && prog.flash_write(buf, addr, whole) <= 0)
+		goto fail;
+	if (tail && prog.flash_write(tail, addr + whole, bsize) <= 0)
+		goto fail;
+
+	for (pos = 0; pos < whole; pos += bsize)
+		flash_state_set(addr + pos, buf + pos);
+	if (tail)
+		flash_state_set(addr + whole, tail);
+	state_written += (len + bsize - 1) / bsize;
+	free(tail);
+
+	return 0;
+fail:
+	flash_state_forget(addr, len);
+	free(tail);
+	return -1;
+}
+
+/* -C: skip the blocks whose hash matches what was last written there */
+static long long write_changed(unsigned char *buf, unsigned long long addr, unsigned long long len)
+{
+	unsigned long long pos, run = 0, n;
+
+	for (pos = 0; pos < len; pos += n) {
+		n = min(bsize, len - pos);
+		if (n < bsize || !flash_state_same(addr + pos, buf + pos) ||
+		    state_spot_check_failed(buf + pos, addr + pos))
+			continue;
+		if (state_write_run(buf + run, addr + run, pos - run))
+			return -1;
+		run = pos + n;
+		state_unchanged++;
+	}
+	if (state_write_run(buf + run, addr + run, len - run))
+		return -1;
+
+	return len;
+}
+
+static int write_from_file(FILE *fp, unsigned long long addr, unsigned long long len)
+{
+	unsigned long long chunk, done, n;
+	unsigned char *buf;
+	long long ret = 0;
+
+	if (!(buf = rw_chunk_alloc(len, &chunk)))
+		return -1;
+	for (done = 0; done < len; done += n) {
+		n = fread(buf, 1, min(chunk, len - done), fp);
+		if (!n) {
+			printf("Error reading file\n");
+			ret = -1;
+			break;
+		}
+		if (flash_state_active())
+			ret = write_changed(buf, addr + done, n);
+		else
+			ret = prog.flash_write(buf, addr + done, n);
+		if (ret <= 0) {
+			printf("Status: BAD(%lld)\n", ret);
+			ret = -1;
+			break;
+		}
+	}
+	free(buf);
+	return ret < 0 ? -1 : 0;
+}
+
+static int verify_with_file(FILE *fp, unsigned long long addr, unsigned long long len)
+{
+	unsigned long long chunk, done, n, i;
+	unsigned char *buf, *ref;
+	int passed = 1;
+
+	if (!(buf = rw_chunk_alloc(len, &chunk)))
+		return -1;
+	if (!(ref = (unsigned char *)malloc(chunk + 1))) {
+		printf("Malloc failed for verify buffer.\n");
+		free(buf);
+		return -1;
+	}
+	fseek(fp, 0, SEEK_SET);
+	for (done = 0; done < len; done += n) {
+		n = fread(ref, 1, min(chunk, len - done), fp);
+		if (!n) {
+			printf("unexpected EOF\n");
+			passed = 0;
+			break;
+		}
+		if (prog.flash_read(buf, addr + done, n) < 0) {
+			passed = 0;
+			break;
+		}
+		for (i = 0; i < n; i++) {
+			if (ref[i] != buf[i]) {
+				printf("0x%08llx: 0x%02x should be 0x%02x\n", done + i, buf[i], ref[i]);
+				flash_state_forget(addr + done + i, 1);
+				passed = 0;
+			}
+		}
+	}
+	/* -C: whatever was not checked cannot be trusted either */
+	if (!passed && done < len)
+		flash_state_forget(addr + done, len - done);
+	free(ref);
+	free(buf);
+	return passed ? 0 : -1;
+}
+
+int main(int argc, char* argv[])
+{
+	int c, vr = 0, svr = 0, ret = 0, i, split = 0, bmt = 0;
+	unsigned int page_size = 0, oob_size = 0;
+	char *str, *fname = NULL, *state_dir = NULL, op = 0;
+	unsigned char *buf, *ref = NULL;
+	long long len = 0, addr = 0, flen = 0, wlen = 0, rlen, to = 0;
 	char *programmer;
 	char *connection = NULL;
-	FILE *fp;
+	FILE *fp = NULL;
 
 	spi_controller = spi_controllers[0];
 
 	title();
 
 #ifdef EEPROM_SUPPORT
-	while ((c = getopt(argc, argv, "diIhveLl:a:w:r:E:f:8p:c:")) != -1)
+	while ((c = getopt(argc, argv, "diIhvesbkUgPuB::Ll:a:m:w:r:C:S:E:f:8p:c:")) != -1)
 #else
-	while ((c = getopt(argc, argv, "diIhveLl:a:w:r:p:c:")) != -1)
+	while ((c = getopt(argc, argv, "diIhvesbkUgPuB::Ll:a:m:w:r:C:S:p:c:")) != -1)
 #endif
 	{
 		switch(c)
@@ -148,6 +388,13 @@ int main(int argc, char* argv[])
 						printf("Error set size %lld, max size %d for EEPROM %s!!!\n", len, mw_eepromsize, eepromname);
 						exit(0);
 					}
+				} else if ((spi_eepromsize = spi_eeprom_size(optarg)) > 0) {
+					memset(eepromname, 0, sizeof(eepromname));
+					strncpy(eepromname, optarg, 10);
+					if (len > spi_eepromsize) {
+						printf("Error set size %lld, max size %d for EEPROM %s!!!\n", len, spi_eepromsize, eepromname);
+						exit(0);
+					}
 				} else {
 					printf("Unknown EEPROM chip %s!!!\n", optarg);
 					exit(0);
@@ -182,6 +429,45 @@ int main(int argc, char* argv[])
 				ECC_fcheck = 0;
 				_ondie_ecc_flag = 0;
 				break;
+			case 's':
+				split = 1;
+				break;
+			case 'b':
+				flash_erase_skip_blank = 1;
+				break;
+			case 'k':
+				snor_erase_keep_edges = 1;
+				break;
+			case 'U':
+				snor_write_incremental = 1;
+				break;
+			case 'g':
+				snor_generic = 1;
+				break;
+			case 'C':
+				state_dir = strdup(optarg);
+				break;
+			case 'S':
+				state_spot_check = atoi(optarg);
+				if (state_spot_check < 0 || state_spot_check > 100) {
+					printf("Bad spot check share %s%%!!!\n", optarg);
+					exit(0);
+				}
+				srand(time(NULL));
+				break;
+			case 'P':
+				snand_two_plane = 1;
+				break;
+			case 'u':
+				snand_partial_program = 1;
+				break;
+			case 'B':
+				bmt = optarg ? atoi(optarg) : 7;
+				if (bmt <= 0 || bmt >= 100) {
+					printf("Bad BMT pool size %s%%!!!\n", optarg);
+					exit(0);
+				}
+				break;
 			case 'l':
 				str = strdup(optarg);
 				len = strtoll(str, NULL, *str && *(str + 1) == 'x' ? 16 : 10);
@@ -190,6 +476,14 @@ int main(int argc, char* argv[])
 				str = strdup(optarg);
 				addr = strtoll(str, NULL, *str && *(str + 1) == 'x' ? 16 : 10);
 				break;
+			case 'm':
+				str = strdup(optarg);
+				to = strtoll(str, NULL, *str && *(str + 1) == 'x' ? 16 : 10);
+				if(!op)
+					op = c;
+				else
+					op = 'x';
+				break;
 			case 'v':
 				vr = 1;
 				break;
@@ -219,7 +513,13 @@ int main(int argc, char* argv[])
 
 	if (op == 0) usage();
 
-	if (op == 'x' || (ECC_ignore && !ECC_fcheck) || (op == 'w' && ECC_ignore)) {
+	if (snand_partial_program && ECC_fcheck) {
+		printf("-u option only with -d, partial programs would corrupt the on-die ECC parity!!!\n");
+		return -1;
+	}
+
+	if (op == 'x' || (ECC_ignore && !ECC_fcheck) || (op == 'w' && ECC_ignore) || (split && ECC_fcheck) ||
+		(bmt && (!ECC_fcheck || op == 'm')) || (state_dir && (!ECC_fcheck || bmt))) {
 		printf("Conflicting options, only one option at a time.\n\n");
 		return -1;
 	}
@@ -232,8 +532,25 @@ int main(int argc, char* argv[])
 	if((flen = flash_cmd_init(&prog)) <= 0)
 		goto out;
 
+	if (bmt) {
+		if (prog.flash_read != snand_read) {
+			printf("-B option only for SPI NAND Flash chips!!!\n");
+			goto out;
+		}
+		if ((flen = snand_bmt_init(bmt)) <= 0)
+			goto out;
+	}
+
+	if (snor_write_incremental && prog.flash_write != snor_write) {
+		printf("-U option only for SPI NOR Flash chips!!!\n");
+		goto out;
+	}
+
+	if (state_dir && (op == 'w' || op == 'e' || op == 'm'))
+		state_init(state_dir, flen, op == 'w' ? addr : 0);
+
 #ifdef EEPROM_SUPPORT
-	if ((eepromsize || mw_eepromsize) && op == 'i') {
+	if ((eepromsize || mw_eepromsize || spi_eepromsize) && op == 'i') {
 		printf("Programmer not supported auto detect EEPROM!\n\n");
 		goto out;
 	}
@@ -249,12 +566,47 @@ int main(int argc, char* argv[])
 			len = flen;
 			printf("Set full erase chip!\n");
 		}
-		if(len % bsize) {
+		if (prog.flash_erase == snor_erase) {
+			if (!snor_erase_keep_edges && ((addr | len) % snor_erase_unit())) {
+				printf("Please set addr and len multiple of the erase size 0x%08X\n", snor_erase_unit());
+				goto out;
+			}
+		} else if(len % bsize) {
 			printf("Please set len = 0x%016llX multiple of the block size 0x%08X\n", len, bsize);
 			goto out;
 		}
 		printf("Erase addr = 0x%016llX, len = 0x%016llX\n", addr, len);
+		if (flash_state_begin(addr, len))
+			goto out;
 		ret = prog.flash_erase(addr, len);
+		if (!ret)
+			flash_state_set_blank(addr, len);
+		else
+			flash_state_forget(addr, len);
+		if(!ret)
+			printf("Status: OK\n");
+		else
+			printf("Status: BAD(%d)\n", ret);
+		goto out;
+	}
+
+	if (op == 'm') {
+		printf("RELOCATE:\n");
+		if (prog.flash_read != snand_read) {
+			printf("-m option only for SPI NAND Flash chips!!!\n");
+			goto out;
+		}
+		if (!len)
+			len = bsize;
+		if ((addr + len > flen) || (to + len > flen)) {
+			printf("Relocate range is out of flash size 0x%016llX\n", flen);
+			goto out;
+		}
+		printf("Relocate addr = 0x%016llX, len = 0x%016llX to addr = 0x%016llX\n", addr, len, to);
+		if (flash_state_begin(to, len))
+			goto out;
+		ret = snand_relocate(addr, to, len);
+		flash_state_forget(to, len);
 		if(!ret)
 			printf("Status: OK\n");
 		else
@@ -263,19 +615,80 @@ int main(int argc, char* argv[])
 	}
 
 	if ((op == 'r') || (op == 'w')) {
-		if(addr && !len)
-			if(op == 'w') {
-				struct stat st;
-				ret = stat(fname, &st);
-				if(ret)
-					return ret;
+		if (split && (prog.flash_read != snand_read || snand_raw_layout(&page_size, &oob_size))) {
+			printf("-s option only for SPI NAND Flash chips!!!\n");
+			goto out;
+		}
+		if (split && ((addr % (page_size + oob_size)) || (len % (page_size + oob_size)))) {
+			printf("Please set addr and len multiple of the raw page size 0x%08X\n", page_size + oob_size);
+			goto out;
+		}
+		if (addr >= flen) {
+			printf("Address 0x%016llX is out of flash size 0x%016llX\n", addr, flen);
+			goto out;
+		}
+		if (op == 'w' && split) {
+			if (!len && (len = nand_merge_size(fname, page_size, oob_size)) <= 0)
+				goto out;
+		} else if (op == 'w') {
+			struct stat st;
+			if (stat(fname, &st)) {
+				printf("Couldn't open file %s for reading.\n", fname);
+				goto out;
+			}
+			if (!len || len > st.st_size)
 				len = st.st_size;
+		} else if (!len)
+			len = flen - addr;
+		if (len > flen - addr)
+			len = flen - addr;
+	}
+
+	if (op == 'w' && !split) {
+		printf("WRITE:\n");
+		fp = fopen(fname, "rb");
+		if (!fp) {
+			printf("Couldn't open file %s for reading.\n", fname);
+			goto out;
+		}
+		printf("Write addr = 0x%016llX, len = 0x%016llX\n", addr, len);
+		if (flash_state_begin(addr, len)) {
+			fclose(fp);
+			goto out;
+		}
+		if (!write_from_file(fp, addr, len)) {
+			if (flash_state_active())
+				printf("Blocks: %u unchanged, %u written\n", state_unchanged, state_written);
+			printf("Status: OK\n");
+			if (vr) {
+				printf("VERIFY:\n");
+				printf("Read addr = 0x%016llX, len = 0x%016llX\n", addr, len);
+				if (!verify_with_file(fp, addr, len))
+					printf("Status: OK\n");
+				else
+					printf("Status: BAD\n");
 			}
-			else
-				len = flen - addr;
-		else if(!addr && !len) {
-			len = flen;
 		}
+		fclose(fp);
+		goto out;
+	}
+
+	if (op == 'r' && !split) {
+		printf("READ:\n");
+		fp = fopen(fname, "wb");
+		if (!fp) {
+			printf("Couldn't open file %s for writing.\n", fname);
+			goto out;
+		}
+		printf("Read addr = 0x%016llX, len = 0x%016llX\n", addr, len);
+		if (!read_to_file(fp, addr, len))
+			printf("Status: OK\n");
+		fclose(fp);
+		goto out;
+	}
+
+	/* -s: the split/merge helpers work on the whole image in memory */
+	if ((op == 'r') || (op == 'w')) {
 		buf = (unsigned char *)malloc(len + 1);
 		if (!buf) {
 			printf("Malloc failed for read buffer.\n");
@@ -285,25 +698,13 @@ int main(int argc, char* argv[])
 
 	if (op == 'w') {
 		printf("WRITE:\n");
-		fp = fopen(fname, "rb");
-		if (!fp) {
-			printf("Couldn't open file %s for reading.\n", fname);
-			free(buf);
-			goto out;
-		}
-		wlen = fread(buf, 1, len, fp);
-		if (ferror(fp)) {
-			printf("Error reading file [%s]\n", fname);
-			if (fp)
-				fclose(fp);
+		if ((wlen = nand_merge_load(fname, buf, len, page_size, oob_size)) < 0) {
 			free(buf);
 			goto out;
 		}
-		if(len == flen)
-			len = wlen;
 		printf("Write addr = 0x%016llX, len = 0x%016llX\n", addr, len);
-		ret = prog.flash_write(buf, addr, len);
-		if(ret > 0) {
+		rlen = prog.flash_write(buf, addr, len);
+		if(rlen > 0) {
 			printf("Status: OK\n");
 			if (vr) {
 				op = 'r';
@@ -313,63 +714,67 @@ int main(int argc, char* argv[])
 			}
 		}
 		else
-			printf("Status: BAD(%d)\n", ret);
-		fclose(fp);
+			printf("Status: BAD(%lld)\n", rlen);
 		free(buf);
 	}
 
 very:
 	if (op == 'r') {
 		if (!svr) printf("READ:\n");
-		else memset(buf, 0, len);
+		else {
+			/* keep the merged image to verify against */
+			ref = buf;
+			buf = (unsigned char *)malloc(len + 1);
+			if (!buf) {
+				printf("Malloc failed for verify buffer.\n");
+				free(ref);
+				goto out;
+			}
+		}
 		printf("Read addr = 0x%016llX, len = 0x%016llX\n", addr, len);
-		ret = prog.flash_read(buf, addr, len);
-		if (ret < 0) {
-			printf("Status: BAD(%d)\n", ret);
+		if (!svr) {
+			if (nand_split_start(fname, buf, len, page_size, oob_size)) {
+				free(buf);
+				goto out;
+			}
+			snand_read_progress = nand_split_update;
+		}
+		rlen = prog.flash_read(buf, addr, len);
+		if (!svr) {
+			snand_read_progress = NULL;
+			if (nand_split_finish() && rlen >= 0)
+				rlen = -1;
+		}
+		if (rlen < 0) {
+			printf("Status: BAD(%lld)\n", rlen);
 			free(buf);
+			free(ref);
 			goto out;
 		}
 		if (svr) {
-			unsigned char ch1;
-			int i;
+			unsigned long long i;
 			bool passed = true;
 
-			fseek(fp, 0, SEEK_SET);
-
-			for(i = 0, ch1 = (unsigned char)getc(fp); i < len; ch1 = (unsigned char)getc(fp), i++){
-				if(ch1 == EOF){
-					printf("unexpected EOF\n");
-					break;
-				}
-				if(ch1 != buf[i]){
-					printf("0x%08x: 0x%02x should be 0x%02x\n", i, buf[i], ch1);
+			for(i = 0; i < len; i++){
+				if(ref[i] != buf[i]){
+					printf("0x%08llx: 0x%02x should be 0x%02x\n", i, buf[i], ref[i]);
 					passed = false;
 				}
 			}
-
+			free(ref);
 			if (passed)
 				printf("Status: OK\n");
 			else
 				printf("Status: BAD\n");
-			fclose(fp);
-			free(buf);
-			goto out;
-		}
-		fp = fopen(fname, "wb");
-		if (!fp) {
-			printf("Couldn't open file %s for writing.\n", fname);
 			free(buf);
 			goto out;
 		}
-		fwrite(buf, 1, len, fp);
-		if (ferror(fp))
-			printf("Error writing file [%s]\n", fname);
-		fclose(fp);
 		free(buf);
 		printf("Status: OK\n");
 	}
 
 out:
+	flash_state_close();
 	spi_controller->shutdown();
 	return 0;
 }
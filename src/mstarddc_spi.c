@@ -35,6 +35,7 @@
 
 #define msg_perr printf
 #define msg_pinfo printf
+#define min(a,b) (((a)<(b))?(a):(b))
 
 struct mstarddc_spi_data {
 	int fd;
@@ -214,6 +215,110 @@ static int mstarddc_spi_end_command(void)
 }
 
 
+#define MSTARDDC_BATCH_MSGS	I2C_RDWR_IOCTL_MAX_MSGS
+#define MSTARDDC_MAX_TRANSFER	64
+
+static int mstarddc_spi_batch_flush(struct i2c_msg *msg, unsigned int *nmsgs)
+{
+	struct i2c_rdwr_ioctl_data i2c_data;
+	int tries, ret = 0;
+
+	if (!*nmsgs)
+		return 0;
+
+	memset(&i2c_data, 0, sizeof(i2c_data));
+	i2c_data.nmsgs = *nmsgs;
+	i2c_data.msgs = msg;
+
+	for (tries = 10; tries; tries--) {
+		if (ioctl(mstarddc_data->fd, I2C_RDWR, &i2c_data) < 0) {
+			msg_perr("Error sending batch of %u messages: errno %d, tries left %d\n",
+				 *nmsgs, errno, tries);
+			ret = -1;
+		} else {
+			ret = 0;
+			break;
+		}
+	}
+	memset(msg, 0, MSTARDDC_BATCH_MSGS * sizeof(*msg));
+	*nmsgs = 0;
+
+	return ret;
+}
+
+/*
+ * Queue write, read and end messages of several transactions into as few
+ * I2C_RDWR ioctls as possible, so a whole command sequence costs a single
+ * round trip. Data is split into messages of at most MSTARDDC_MAX_TRANSFER
+ * bytes, as send_command() gets it through SPI_CONTROLLER_Write_NByte().
+ * Returns 0 upon success, a negative number upon errors.
+ */
+static int mstarddc_spi_send_batch(const struct spi_transfer *xfers, unsigned int count)
+{
+	static uint8_t cmd_read = MSTARDDC_SPI_READ;
+	static uint8_t cmd_end = MSTARDDC_SPI_END;
+	struct i2c_msg msg[MSTARDDC_BATCH_MSGS];
+	uint8_t *cmd, *pos;
+	unsigned int i, off, n, nmsgs = 0;
+	size_t cmdsz = 0;
+	int ret = 0;
+
+	for (i = 0; i < count; i++)
+		cmdsz += xfers[i].writecnt + (xfers[i].writecnt + MSTARDDC_MAX_TRANSFER - 1) / MSTARDDC_MAX_TRANSFER;
+
+	cmd = malloc(cmdsz ? cmdsz : 1);
+	if (cmd == NULL) {
+		msg_perr("Error allocating memory: errno %d.\n", errno);
+		return -1;
+	}
+	pos = cmd;
+
+	memset(&msg, 0, sizeof(msg));
+	for (i = 0; i < count && !ret; i++) {
+		for (off = 0; off < xfers[i].writecnt && !ret; off += n) {
+			n = min(MSTARDDC_MAX_TRANSFER, xfers[i].writecnt - off);
+			if (nmsgs + 1 > MSTARDDC_BATCH_MSGS && (ret = mstarddc_spi_batch_flush(msg, &nmsgs)))
+				break;
+			pos[0] = MSTARDDC_SPI_WRITE;
+			memcpy(pos + 1, xfers[i].writearr + off, n);
+			msg[nmsgs].addr = mstarddc_data->addr;
+			msg[nmsgs].len = n + 1;
+			msg[nmsgs].buf = pos;
+			nmsgs++;
+			pos += n + 1;
+		}
+		for (off = 0; off < xfers[i].readcnt && !ret; off += n) {
+			n = min(MSTARDDC_MAX_TRANSFER, xfers[i].readcnt - off);
+			if (nmsgs + 2 > MSTARDDC_BATCH_MSGS && (ret = mstarddc_spi_batch_flush(msg, &nmsgs)))
+				break;
+			msg[nmsgs].addr = mstarddc_data->addr;
+			msg[nmsgs].len = 1;
+			msg[nmsgs].buf = &cmd_read;
+			nmsgs++;
+			msg[nmsgs].addr = mstarddc_data->addr;
+			msg[nmsgs].len = n;
+			msg[nmsgs].flags = I2C_M_RD;
+			msg[nmsgs].buf = xfers[i].readarr + off;
+			nmsgs++;
+		}
+		if (ret || (nmsgs + 1 > MSTARDDC_BATCH_MSGS && (ret = mstarddc_spi_batch_flush(msg, &nmsgs))))
+			break;
+		msg[nmsgs].addr = mstarddc_data->addr;
+		msg[nmsgs].len = 1;
+		msg[nmsgs].buf = &cmd_end;
+		nmsgs++;
+	}
+	if (!ret)
+		ret = mstarddc_spi_batch_flush(msg, &nmsgs);
+
+	free(cmd);
+
+	if (ret != 0)
+		mstarddc_data->doreset = 0;
+
+	return ret;
+}
+
 /* Returns 0 upon success, a negative number upon errors. */
 static int mstarddc_spi_init(const char *connection)
 {
@@ -318,5 +423,6 @@ const struct spi_controller mstarddc_spictrl = {
 	.shutdown = mstarddc_spi_shutdown,
 	.send_command = mstarddc_spi_send_command,
 	.cs_release = mstarddc_spi_end_command,
-	.max_transfer = 64,
+	.send_batch = mstarddc_spi_send_batch,
+	.max_transfer = MSTARDDC_MAX_TRANSFER,
 };
@@ -30,7 +30,7 @@ extern struct gpio_cmd bb_func;
 extern char eepromname[12];
 extern unsigned int bsize;
 
-int mw_eeprom_read(unsigned char *buf, unsigned long from, unsigned long len)
+long long mw_eeprom_read(unsigned char *buf, unsigned long long from, unsigned long long len)
 {
 	unsigned char *pbuf, ebuf[MAX_MW_EEPROM_SIZE];
 
@@ -44,13 +44,13 @@ int mw_eeprom_read(unsigned char *buf, unsigned long from, unsigned long len)
 	Read_EEPROM_3wire(pbuf, mw_eepromsize);
 	memcpy(buf, pbuf + from, len);
 
-	printf("Read [%lu] bytes from [%s] EEPROM address 0x%08lu\n", len, eepromname, from);
+	printf("Read [%llu] bytes from [%s] EEPROM address 0x%08llu\n", len, eepromname, from);
 	timer_end();
 
-	return (int)len;
+	return (long long)len;
 }
 
-int mw_eeprom_erase(unsigned long offs, unsigned long len)
+int mw_eeprom_erase(unsigned long long offs, unsigned long long len)
 {
 	unsigned char *pbuf, ebuf[MAX_MW_EEPROM_SIZE];
 
@@ -70,18 +70,18 @@ int mw_eeprom_erase(unsigned long offs, unsigned long len)
 
 	if (offs || len < mw_eepromsize) {
 		if (Write_EEPROM_3wire(pbuf, mw_eepromsize) < 0) {
-			printf("Failed to erase [%lu] bytes of [%s] EEPROM address 0x%08lu\n", len, eepromname, offs);
+			printf("Failed to erase [%llu] bytes of [%s] EEPROM address 0x%08llu\n", len, eepromname, offs);
 			return -1;
 		}
 	}
 
-	printf("Erased [%lu] bytes of [%s] EEPROM address 0x%08lu\n", len, eepromname, offs);
+	printf("Erased [%llu] bytes of [%s] EEPROM address 0x%08llu\n", len, eepromname, offs);
 	timer_end();
 
 	return 0;
 }
 
-int mw_eeprom_write(unsigned char *buf, unsigned long to, unsigned long len)
+long long mw_eeprom_write(unsigned char *buf, unsigned long long to, unsigned long long len)
 {
 	unsigned char *pbuf, ebuf[MAX_MW_EEPROM_SIZE];
 
@@ -100,14 +100,14 @@ int mw_eeprom_write(unsigned char *buf, unsigned long to, unsigned long len)
 	Erase_EEPROM_3wire(mw_eepromsize);
 
 	if (Write_EEPROM_3wire(pbuf, mw_eepromsize) < 0) {
-		printf("Failed to write [%lu] bytes of [%s] EEPROM address 0x%08lu\n", len, eepromname, to);
+		printf("Failed to write [%llu] bytes of [%s] EEPROM address 0x%08llu\n", len, eepromname, to);
 		return -1;
 	}
 
-	printf("Wrote [%lu] bytes to [%s] EEPROM address 0x%08lu\n", len, eepromname, to);
+	printf("Wrote [%llu] bytes to [%s] EEPROM address 0x%08llu\n", len, eepromname, to);
 	timer_end();
 
-	return (int)len;
+	return (long long)len;
 }
 
 /*
@@ -155,7 +155,7 @@ static char *__itoa(int a)
 }
 
 
-long mw_init(void)
+long long mw_init(void)
 {
 	if (mw_eepromsize <= 0) {
 		printf("Microwire EEPROM Not Detected!\n");
@@ -170,7 +170,7 @@ long mw_init(void)
 	printf("Microwire EEPROM chip: %s, Size: %d bytes, Org: %d bits, fix addr len: %s\n", eepromname, mw_eepromsize / (org ? 2 : 1),
 			org ? 16 : 8, fix_addr_len ? __itoa(fix_addr_len) : "Auto");
 
-	return (long)mw_eepromsize;
+	return (long long)mw_eepromsize;
 }
 
 void support_mw_eeprom_list(void)
@@ -15,10 +15,10 @@
 #ifndef __MW_EEPROM_API_H__
 #define __MW_EEPROM_API_H__
 
-int mw_eeprom_read(unsigned char *buf, unsigned long from, unsigned long len);
-int mw_eeprom_erase(unsigned long offs, unsigned long len);
-int mw_eeprom_write(unsigned char *buf, unsigned long to, unsigned long len);
-long mw_init(void);
+long long mw_eeprom_read(unsigned char *buf, unsigned long long from, unsigned long long len);
+int mw_eeprom_erase(unsigned long long offs, unsigned long long len);
+long long mw_eeprom_write(unsigned char *buf, unsigned long long to, unsigned long long len);
+long long mw_init(void);
 void support_mw_eeprom_list(void);
 
 #endif /* __MW_EEPROM_API_H__ */
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2026 McMCC <mcmcc@mail.ru>
+ * nand_split.c
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Raw (-d) NAND images interleave every page with its spare area. Reads are
+ * split into <name>.data and <name>.oob by a worker thread which follows the
+ * read progress, writes merge both files back into the interleaved layout.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "nand_split.h"
+
+static struct {
+	pthread_t		thread;
+	pthread_mutex_t		lock;
+	pthread_cond_t		cond;
+	const unsigned char	*buf;
+	unsigned long long	len;
+	unsigned long long	done;
+	unsigned int		page_size;
+	unsigned int		oob_size;
+	int			finished;
+	int			error;
+	FILE			*data;
+	FILE			*oob;
+} split;
+
+static FILE *split_open(const char *name, const char *ext, const char *mode)
+{
+	char *path;
+	FILE *fp;
+
+	path = malloc(strlen(name) + strlen(ext) + 1);
+	if (!path)
+		return NULL;
+	sprintf(path, "%s%s", name, ext);
+	fp = fopen(path, mode);
+	if (!fp)
+		printf("Couldn't open file %s.\n", path);
+	free(path);
+
+	return fp;
+}
+
+static void *split_worker(void *arg)
+{
+	unsigned long long pos = 0, avail;
+	unsigned int raw = split.page_size + split.oob_size;
+	int finished;
+
+	for (;;) {
+		pthread_mutex_lock(&split.lock);
+		while (split.done - pos < raw && !split.finished)
+			pthread_cond_wait(&split.cond, &split.lock);
+		avail = split.done;
+		finished = split.finished;
+		pthread_mutex_unlock(&split.lock);
+
+		for (; avail - pos >= raw; pos += raw) {
+			if (fwrite(split.buf + pos, 1, split.page_size, split.data) != split.page_size ||
+			    fwrite(split.buf + pos + split.page_size, 1, split.oob_size, split.oob) != split.oob_size) {
+				split.error = 1;
+				return NULL;
+			}
+		}
+
+		if (finished && split.done - pos < raw)
+			break;
+	}
+
+	return NULL;
+}
+
+int nand_split_start(const char *name, const unsigned char *buf, unsigned long long len,
+		unsigned int page_size, unsigned int oob_size)
+{
+	memset(&split, 0, sizeof(split));
+	split.buf = buf;
+	split.len = len;
+	split.page_size = page_size;
+	split.oob_size = oob_size;
+
+	if (!(split.data = split_open(name, ".data", "wb")))
+		return -1;
+	if (!(split.oob = split_open(name, ".oob", "wb"))) {
+		fclose(split.data);
+		return -1;
+	}
+
+	pthread_mutex_init(&split.lock, NULL);
+	pthread_cond_init(&split.cond, NULL);
+
+	if (pthread_create(&split.thread, NULL, split_worker, NULL)) {
+		printf("Couldn't start the split thread.\n");
+		fclose(split.data);
+		fclose(split.oob);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Called by the read path, done is the number of bytes of buf already read */
+void nand_split_update(unsigned long long done)
+{
+	pthread_mutex_lock(&split.lock);
+	split.done = done;
+	pthread_cond_signal(&split.cond);
+	pthread_mutex_unlock(&split.lock);
+}
+
+int nand_split_finish(void)
+{
+	pthread_mutex_lock(&split.lock);
+	split.finished = 1;
+	pthread_cond_signal(&split.cond);
+	pthread_mutex_unlock(&split.lock);
+
+	pthread_join(split.thread, NULL);
+	pthread_cond_destroy(&split.cond);
+	pthread_mutex_destroy(&split.lock);
+
+	if (fclose(split.data) || fclose(split.oob))
+		split.error = 1;
+	if (split.error)
+		printf("Error writing split files\n");
+
+	return split.error ? -1 : 0;
+}
+
+/* Size of the interleaved image described by <name>.data */
+long long nand_merge_size(const char *name, unsigned int page_size, unsigned int oob_size)
+{
+	FILE *fp;
+	struct stat st;
+	int ret;
+
+	if (!(fp = split_open(name, ".data", "rb")))
+		return -1;
+	ret = fstat(fileno(fp), &st);
+	fclose(fp);
+	if (ret)
+		return -1;
+
+	return (st.st_size + page_size - 1) / page_size * (page_size + oob_size);
+}
+
+/*
+ * Fill buf with up to len bytes of the interleaved image. Missing data or
+ * OOB bytes are left erased (0xFF).
+ */
+long long nand_merge_load(const char *name, unsigned char *buf, unsigned long long len,
+		unsigned int page_size, unsigned int oob_size)
+{
+	FILE *data, *oob;
+	unsigned long long pos;
+	unsigned int raw = page_size + oob_size;
+	size_t n;
+	long long wlen = 0;
+
+	if (!(data = split_open(name, ".data", "rb")))
+		return -1;
+	if (!(oob = split_open(name, ".oob", "rb"))) {
+		fclose(data);
+		return -1;
+	}
+
+	memset(buf, 0xff, len);
+	for (pos = 0; pos + raw <= len; pos += raw) {
+		if (!(n = fread(buf + pos, 1, page_size, data)))
+			break;
+		if (fread(buf + pos + page_size, 1, oob_size, oob) != oob_size)
+			memset(buf + pos + page_size, 0xff, oob_size);
+		wlen = pos + raw;
+		if (n != page_size)
+			break;
+	}
+
+	if (ferror(data) || ferror(oob)) {
+		printf("Error reading split files [%s]\n", name);
+		wlen = -1;
+	}
+	fclose(data);
+	fclose(oob);
+
+	return wlen;
+}
+/* End of [nand_split.c] package */
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2026 McMCC <mcmcc@mail.ru>
+ * nand_split.h
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef __NAND_SPLIT_H__
+#define __NAND_SPLIT_H__
+
+int nand_split_start(const char *name, const unsigned char *buf, unsigned long long len,
+		unsigned int page_size, unsigned int oob_size);
+void nand_split_update(unsigned long long done);
+int nand_split_finish(void);
+
+long long nand_merge_size(const char *name, unsigned int page_size, unsigned int oob_size);
+long long nand_merge_load(const char *name, unsigned char *buf, unsigned long long len,
+		unsigned int page_size, unsigned int oob_size);
+
+#endif /* __NAND_SPLIT_H__ */
+/* End of [nand_split.h] package */
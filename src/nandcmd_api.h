@@ -15,14 +15,23 @@
 #ifndef __NANDCMD_API_H__
 #define __NANDCMD_API_H__
 
-int snand_read(unsigned char *buf, unsigned long from, unsigned long len);
-int snand_erase(unsigned long offs, unsigned long len);
-int snand_write(unsigned char *buf, unsigned long to, unsigned long len);
-long snand_init(void);
+long long snand_read(unsigned char *buf, unsigned long long from, unsigned long long len);
+int snand_erase(unsigned long long offs, unsigned long long len);
+int snand_relocate(unsigned long long offs, unsigned long long to, unsigned long long len);
+long long snand_write(unsigned char *buf, unsigned long long to, unsigned long long len);
+long long snand_init(void);
 void support_snand_list(void);
+int snand_raw_layout(unsigned int *page_size, unsigned int *oob_size);
+long long snand_bmt_init(unsigned int pool_percent);
+int snand_read_uid(unsigned char *uid, int len);
+
+/* Called after each page of snand_read() with the bytes read so far */
+extern void (*snand_read_progress)(unsigned long long done);
 
 extern int ECC_fcheck;
 extern int ECC_ignore;
+extern int snand_two_plane;
+extern int snand_partial_program;
 extern unsigned char _ondie_ecc_flag;
 
 #endif /* __NANDCMD_API_H__ */
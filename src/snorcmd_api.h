@@ -15,11 +15,23 @@
 #ifndef __SNORCMD_API_H__
 #define __SNORCMD_API_H__
 
-int snor_read(unsigned char *buf, unsigned long from, unsigned long len);
-int snor_erase(unsigned long offs, unsigned long len);
-int snor_write(unsigned char *buf, unsigned long to, unsigned long len);
-long snor_init(void);
+long long snor_read(unsigned char *buf, unsigned long long from, unsigned long long len);
+int snor_erase(unsigned long long offs, unsigned long long len);
+long long snor_write(unsigned char *buf, unsigned long long to, unsigned long long len);
+long long snor_init(void);
+int snor_match_id(const unsigned char *id);
+unsigned int snor_erase_unit(void);
+int snor_read_uid(unsigned char *uid, int len);
 void support_snor_list(void);
 
+/* Erase ranges that are not aligned to the erase unit and restore the data around them */
+extern int snor_erase_keep_edges;
+
+/* Write only the sectors that differ, erasing them only where bits must be set */
+extern int snor_write_incremental;
+
+/* Run unknown IDs without SFDP with a basic profile sized from the ID */
+extern int snor_generic;
+
 #endif /* __SNORCMD_API_H__ */
 /* End of [snorcmd_api.h] package */
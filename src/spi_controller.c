@@ -10,6 +10,7 @@
  *      SPI_CONTROLLER_Read_NByte         To provide interface for read N bytes from SPI bus.
  *      SPI_CONTROLLER_Chip_Select_Low    To provide interface for set chip select low in SPI bus.
  *      SPI_CONTROLLER_Chip_Select_High   To provide interface for set chip select high in SPI bus.
+ *      SPI_CONTROLLER_Send_Batch         To provide interface for run several SPI transactions at once.
  *
  * DEPENDENCIES
  *
@@ -49,12 +50,12 @@ SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Chip_Select_Low( void )
 
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_NByte( u8 *ptr_rtn_data, u32 len, SPI_CONTROLLER_SPEED_T speed )
 {
-	u32 chunk_sz = min(len, spi_controller->max_transfer);
-	int ret;
+	u32 chunk_sz = spi_controller->max_transfer ? min(len, spi_controller->max_transfer) : len;
+	int ret = 0;
 
 	/*
 	 * Handle chunking the transfer when the controller has a smaller max_transfer than the
-	 * requested amount.
+	 * requested amount. A max_transfer of zero means the controller takes any length.
 	 */
 	while(len) {
 		int read_sz = min(chunk_sz, len);
@@ -70,12 +71,12 @@ SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_NByte( u8 *ptr_rtn_data, u32 len, SPI_C
 
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Write_NByte( u8 *ptr_data, u32 len, SPI_CONTROLLER_SPEED_T speed )
 {
-	u32 chunk_sz = min(len, spi_controller->max_transfer);
-	int ret;
+	u32 chunk_sz = spi_controller->max_transfer ? min(len, spi_controller->max_transfer) : len;
+	int ret = 0;
 
 	/*
 	 * Handle chunking the transfer when the controller has a smaller max_transfer than the
-	 * requested amount.
+	 * requested amount. A max_transfer of zero means the controller takes any length.
 	 */
 	while(len) {
 		int write_sz = min(chunk_sz, len);
@@ -89,6 +90,26 @@ SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Write_NByte( u8 *ptr_data, u32 len, SPI_CONT
 	return (SPI_CONTROLLER_RTN_T) ret;
 }
 
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Send_Batch( const struct spi_transfer *xfers, u32 count )
+{
+	u32 i;
+	int ret = 0;
+
+	if(spi_controller->send_batch)
+		return (SPI_CONTROLLER_RTN_T)spi_controller->send_batch(xfers, count);
+
+	/* One transaction at a time, chunked to max_transfer like any other command */
+	for(i = 0; i < count && !ret; i++) {
+		SPI_CONTROLLER_Chip_Select_Low();
+		ret = SPI_CONTROLLER_Write_NByte((u8 *)xfers[i].writearr, xfers[i].writecnt, SPI_CONTROLLER_SPEED_SINGLE);
+		if(!ret)
+			ret = SPI_CONTROLLER_Read_NByte(xfers[i].readarr, xfers[i].readcnt, SPI_CONTROLLER_SPEED_SINGLE);
+		SPI_CONTROLLER_Chip_Select_High();
+	}
+
+	return (SPI_CONTROLLER_RTN_T) ret;
+}
+
 #if 0
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Xfer_NByte( u8 *ptr_data_in, u32 len_in, u8 *ptr_data_out, u32 len_out, SPI_CONTROLLER_SPEED_T speed )
 {
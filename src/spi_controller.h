@@ -10,6 +10,7 @@
  *      SPI_CONTROLLER_Read_NByte         To provide interface for read N bytes from SPI bus.
  *      SPI_CONTROLLER_Chip_Select_Low    To provide interface for set chip select low in SPI bus.
  *      SPI_CONTROLLER_Chip_Select_High   To provide interface for set chip select high in SPI bus.
+ *      SPI_CONTROLLER_Send_Batch         To provide interface for run several SPI transactions at once.
  *
  * DEPENDENCIES
  *
@@ -52,6 +53,14 @@ typedef enum{
 	SPI_CONTROLLER_MODE_NO
 } SPI_CONTROLLER_MODE_T;
 
+/* One chip select framed transaction: write writecnt bytes, then read readcnt bytes */
+struct spi_transfer {
+	unsigned int writecnt;
+	unsigned int readcnt;
+	const unsigned char *writearr;
+	unsigned char *readarr;
+};
+
 struct spi_controller {
 	const char *name;
 	int (*init)(const char *);
@@ -59,6 +68,8 @@ struct spi_controller {
 	int (*send_command)(unsigned int, unsigned int, const unsigned char *, unsigned char *);
 	int (*cs_assert)(void);
 	int (*cs_release)(void);
+	/* optional, runs several transactions in one bus submission */
+	int (*send_batch)(const struct spi_transfer *, unsigned int);
 	unsigned int max_transfer;
 };
 
@@ -182,6 +193,26 @@ SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Chip_Select_Low( void );
  */
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Chip_Select_High( void );
 
+/*------------------------------------------------------------------------------------
+ * FUNCTION: SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Send_Batch( const struct spi_transfer *xfers,
+ *                                                           u32                        count )
+ * PURPOSE : To provide interface for run several chip select framed transactions.
+ * AUTHOR  :
+ * CALLED BY
+ *   -
+ * CALLS
+ *   -
+ * PARAMs  :
+ *   INPUT : xfers - The transactions, in bus order.
+ *           count - The number of transactions.
+ *   OUTPUT: None
+ * RETURN  : SPI_RTN_NO_ERROR - Successful.   Otherwise - Failed.
+ * NOTES   : Controllers without send_batch get one transaction at a time.
+ * MODIFICTION HISTORY:
+ *------------------------------------------------------------------------------------
+ */
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Send_Batch( const struct spi_transfer *xfers, u32 count );
+
 #if 0
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Xfer_NByte( u8 *ptr_data_in, u32 len_in, u8 *ptr_data_out, u32 len_out, SPI_CONTROLLER_SPEED_T speed );
 #endif
@@ -0,0 +1,352 @@
+/*
+ * Copyright (C) 2026 McMCC <mcmcc@mail.ru>
+ * spi_eeprom.c
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * 25xxx SPI EEPROMs (Microchip 25LC/25AA, Atmel AT25, ST M95) on the SPI
+ * bus of the programmer, same socket pinout as SPI NOR. They have no RDID
+ * and are picked with -E. There is nothing to erase: every byte can be
+ * rewritten through a page write, which the chip finishes on its own
+ * while reporting WIP in the status register.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "spi_controller.h"
+#include "spi_eeprom_api.h"
+#include "types.h"
+#include "timer.h"
+
+#define min(a,b) (((a)<(b))?(a):(b))
+
+#define SEEP_WRSR			0x01	/* Write status register */
+#define SEEP_WRITE			0x02	/* Write data */
+#define SEEP_READ			0x03	/* Read data */
+#define SEEP_RDSR			0x05	/* Read status register */
+#define SEEP_WREN			0x06	/* Write enable */
+#define SEEP_A8				0x08	/* 9th address bit of 1-byte address parts */
+
+#define SEEP_SR_WIP			0x01	/* Write in progress */
+#define SEEP_SR_BP			0x0c	/* Block protect bits */
+
+#define SEEP_SR_BURST			31	/* status bytes per poll, one CH341A USB packet */
+#define SEEP_SR_FAST_POLLS		16	/* bursts before sleeping between them */
+#define SEEP_WRITE_MS			10	/* worst page write time of the listed parts */
+
+struct SPI_EEPROM {
+	char *name;
+	unsigned int size;
+	unsigned int page;
+	unsigned char addr_len;
+};
+
+/* Page sizes are the smallest any vendor uses for that density */
+static const struct SPI_EEPROM spi_eepromlist[] = {
+	{ "25c010",	128,	16,	1 },
+	{ "25c020",	256,	16,	1 },
+	{ "25c040",	512,	16,	1 },
+	{ "25c080",	1024,	16,	2 },
+	{ "25c160",	2048,	16,	2 },
+	{ "25c320",	4096,	32,	2 },
+	{ "25c640",	8192,	32,	2 },
+	{ "25c128",	16384,	64,	2 },
+	{ "25c256",	32768,	64,	2 },
+	{ "25c512",	65536,	128,	2 },
+	{ "25c1024",	131072,	256,	3 },
+	{ "25m02",	262144,	256,	3 },
+	{ 0, 0, 0, 0 }
+};
+
+extern char eepromname[12];
+extern unsigned int bsize;
+int spi_eepromsize = 0;
+
+static const struct SPI_EEPROM *spi_eeprom;
+
+int spi_eeprom_size(char *eepromname)
+{
+	int i;
+
+	for (i = 0; spi_eepromlist[i].size; i++) {
+		if (strstr(spi_eepromlist[i].name, eepromname)) {
+			spi_eeprom = &spi_eepromlist[i];
+			return spi_eepromlist[i].size;
+		}
+	}
+
+	return -1;
+}
+
+/* Opcode and address as the part expects them, returns the header length */
+static int spi_eeprom_cmd(u8 *cmd, u8 opcode, u32 addr)
+{
+	int n = 0, i;
+
+	if (spi_eeprom->addr_len == 1 && (addr & 0x100))
+		opcode |= SEEP_A8;
+	cmd[n++] = opcode;
+	for (i = spi_eeprom->addr_len - 1; i >= 0; i--)
+		cmd[n++] = addr >> (8 * i);
+
+	return n;
+}
+
+/*
+ * RDSR is sent once; with CS held the chip keeps returning the status
+ * register, so each transfer brings SEEP_SR_BURST fresh samples.
+ */
+static int spi_eeprom_wait_ready(void)
+{
+	u8 cmd = SEEP_RDSR, sr[SEEP_SR_BURST];
+	int count, i, ret = -1;
+
+	SPI_CONTROLLER_Chip_Select_Low();
+	if (SPI_CONTROLLER_Write_NByte(&cmd, 1, SPI_CONTROLLER_SPEED_SINGLE)) {
+		SPI_CONTROLLER_Chip_Select_High();
+		return -1;
+	}
+
+	sr[SEEP_SR_BURST - 1] = SEEP_SR_WIP;
+	for (count = 0; count < SEEP_SR_FAST_POLLS + SEEP_WRITE_MS * 10; count++) {
+		if (SPI_CONTROLLER_Read_NByte(sr, sizeof(sr), SPI_CONTROLLER_SPEED_SINGLE))
+			break;
+		for (i = 0; i < SEEP_SR_BURST; i++)
+			if (!(sr[i] & SEEP_SR_WIP))
+				break;
+		if (i < SEEP_SR_BURST) {
+			ret = 0;
+			break;
+		}
+		if (count >= SEEP_SR_FAST_POLLS)
+			usleep(100);
+	}
+	SPI_CONTROLLER_Chip_Select_High();
+
+	if (ret)
+		printf("%s: read_sr fail: %x\n", __func__, sr[SEEP_SR_BURST - 1]);
+	return ret;
+}
+
+/* Clear the block protect bits left by a previous owner */
+static int spi_eeprom_unprotect(void)
+{
+	u8 cmd_wren[1] = { SEEP_WREN };
+	u8 cmd_rdsr[1] = { SEEP_RDSR };
+	u8 cmd_wrsr[2] = { SEEP_WRSR, 0 };
+	u8 sr;
+	struct spi_transfer rdsr = { sizeof(cmd_rdsr), 1, cmd_rdsr, &sr };
+	struct spi_transfer xfers[2] = {
+		{ sizeof(cmd_wren), 0, cmd_wren, NULL },
+		{ sizeof(cmd_wrsr), 0, cmd_wrsr, NULL },
+	};
+
+	if (SPI_CONTROLLER_Send_Batch(&rdsr, 1))
+		return -1;
+	if (!(sr & SEEP_SR_BP))
+		return 0;
+
+	if (SPI_CONTROLLER_Send_Batch(xfers, 2))
+		return -1;
+
+	return spi_eeprom_wait_ready();
+}
+
+/*
+ * WREN, the page write and the first status burst go out as one batch, so
+ * a page costs a single USB round trip when the chip is quick enough.
+ */
+static int spi_eeprom_write_page(u8 *pkt, const u8 *data, u32 len, u32 to)
+{
+	u8 cmd_wren[1] = { SEEP_WREN };
+	u8 cmd_rdsr[1] = { SEEP_RDSR };
+	u8 sr[SEEP_SR_BURST];
+	struct spi_transfer xfers[3] = {
+		{ sizeof(cmd_wren), 0, cmd_wren, NULL },
+		{ 0, 0, pkt, NULL },
+		{ sizeof(cmd_rdsr), sizeof(sr), cmd_rdsr, sr },
+	};
+	int i, n;
+
+	n = spi_eeprom_cmd(pkt, SEEP_WRITE, to);
+	memcpy(pkt + n, data, len);
+	xfers[1].writecnt = n + len;
+
+	if (SPI_CONTROLLER_Send_Batch(xfers, 3))
+		return -1;
+
+	for (i = 0; i < SEEP_SR_BURST; i++)
+		if (!(sr[i] & SEEP_SR_WIP))
+			return 0;
+
+	return spi_eeprom_wait_ready();
+}
+
+/* One READ streams the whole range out */
+static int spi_eeprom_read_range(u8 *buf, u32 from, u32 len)
+{
+	u8 cmd[4];
+	int n, ret;
+
+	n = spi_eeprom_cmd(cmd, SEEP_READ, from);
+
+	SPI_CONTROLLER_Chip_Select_Low();
+	ret = SPI_CONTROLLER_Write_NByte(cmd, n, SPI_CONTROLLER_SPEED_SINGLE);
+	if (!ret)
+		ret = SPI_CONTROLLER_Read_NByte(buf, len, SPI_CONTROLLER_SPEED_SINGLE);
+	SPI_CONTROLLER_Chip_Select_High();
+
+	return ret ? -1 : 0;
+}
+
+long long spi_eeprom_read(unsigned char *buf, unsigned long long from, unsigned long long len)
+{
+	if (len == 0 || from + len > spi_eepromsize)
+		return -1;
+
+	timer_start();
+	if (spi_eeprom_read_range(buf, from, len)) {
+		printf("Couldnt read [%llu] bytes from [%s] EEPROM address 0x%08llX\n", len, eepromname, from);
+		return -1;
+	}
+
+	printf("Read [%llu] bytes from [%s] EEPROM address 0x%08llX\n", len, eepromname, from);
+	timer_end();
+
+	return (long long)len;
+}
+
+/*
+ * Read what the range holds first and write only the bytes of each page
+ * that differ, from the first changed byte to the last one. Pages that
+ * already match cost nothing.
+ */
+static int spi_eeprom_update(const u8 *buf, u32 to, u32 len)
+{
+	u32 page = spi_eeprom->page, pos, n, first, last;
+	u32 unchanged = 0, written = 0;
+	u8 *old, *pkt;
+	int ret = 0;
+
+	old = malloc(len);
+	pkt = malloc(4 + page);
+	if (!old || !pkt) {
+		printf("Malloc failed for EEPROM buffer.\n");
+		ret = -1;
+		goto out;
+	}
+
+	if (spi_eeprom_wait_ready() || spi_eeprom_unprotect() || spi_eeprom_read_range(old, to, len)) {
+		ret = -1;
+		goto out;
+	}
+
+	for (pos = 0; pos < len; pos += n) {
+		n = min(page - (to + pos) % page, len - pos);
+		for (first = 0; first < n && old[pos + first] == buf[pos + first]; first++)
+			;
+		if (first == n) {
+			unchanged++;
+			continue;
+		}
+		for (last = n - 1; old[pos + last] == buf[pos + last]; last--)
+			;
+		if (spi_eeprom_write_page(pkt, buf + pos + first, last - first + 1, to + pos + first)) {
+			printf("%s: page write fail at 0x%x\n", __func__, to + pos + first);
+			ret = -1;
+			goto out;
+		}
+		written++;
+	}
+
+	printf("Pages: %u unchanged, %u written\n", unchanged, written);
+out:
+	free(old);
+	free(pkt);
+
+	return ret;
+}
+
+int spi_eeprom_erase(unsigned long long offs, unsigned long long len)
+{
+	u8 *ff;
+	int ret;
+
+	if (len == 0 || offs + len > spi_eepromsize)
+		return -1;
+
+	ff = malloc(len);
+	if (!ff) {
+		printf("Malloc failed for EEPROM buffer.\n");
+		return -1;
+	}
+	memset(ff, 0xff, len);
+
+	timer_start();
+	ret = spi_eeprom_update(ff, offs, len);
+	free(ff);
+	if (ret) {
+		printf("Failed to erase [%llu] bytes of [%s] EEPROM address 0x%08llX\n", len, eepromname, offs);
+		return -1;
+	}
+
+	printf("Erased [%llu] bytes of [%s] EEPROM address 0x%08llX\n", len, eepromname, offs);
+	timer_end();
+
+	return 0;
+}
+
+long long spi_eeprom_write(unsigned char *buf, unsigned long long to, unsigned long long len)
+{
+	if (len == 0 || to + len > spi_eepromsize)
+		return -1;
+
+	timer_start();
+	if (spi_eeprom_update(buf, to, len)) {
+		printf("Failed to write [%llu] bytes of [%s] EEPROM address 0x%08llX\n", len, eepromname, to);
+		return -1;
+	}
+
+	printf("Wrote [%llu] bytes to [%s] EEPROM address 0x%08llX\n", len, eepromname, to);
+	timer_end();
+
+	return (long long)len;
+}
+
+long long spi_eeprom_init(void)
+{
+	if (spi_eepromsize <= 0 || !spi_eeprom) {
+		printf("SPI EEPROM Not Detected!\n");
+		return -1;
+	}
+
+	bsize = 1;
+
+	printf("SPI EEPROM chip: %s, Size: %d bytes, Page: %d bytes, Addr: %d bytes\n", eepromname, spi_eepromsize,
+			spi_eeprom->page, spi_eeprom->addr_len);
+
+	return (long long)spi_eepromsize;
+}
+
+void support_spi_eeprom_list(void)
+{
+	int i;
+
+	printf("SPI EEPROM Support List:\n");
+	for (i = 0; spi_eepromlist[i].size; i++)
+		printf("%03d. %s\n", i + 1, spi_eepromlist[i].name);
+}
+/* End of [spi_eeprom.c] package */
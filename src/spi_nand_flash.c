@@ -14,8 +14,10 @@
  *      SPI_NAND_Flash_Write_Nbyte      To provide interface for Write N Bytes into SPI NAND Flash.
  *      SPI_NAND_Flash_Read_Byte        To provide interface for read 1 Bytes from SPI NAND Flash.
  *      SPI_NAND_Flash_Read_DWord       To provide interface for read Double Word from SPI NAND Flash.
+ *      SPI_NAND_Flash_Read_Random      To provide interface for read a few Bytes at any address.
  *      SPI_NAND_Flash_Read_NByte       To provide interface for Read N Bytes from SPI NAND Flash.
  *      SPI_NAND_Flash_Erase            To provide interface for Erase SPI NAND Flash.
+ *      SPI_NAND_Flash_Relocate_Block   To provide interface for move a block inside SPI NAND Flash.
  *
  * DEPENDENCIES
  *
@@ -36,8 +38,10 @@
 #include "types.h"
 #include "spi_nand_flash.h"
 #include "spi_controller.h"
+#include "flashcmd_api.h"
 #include "nandcmd_api.h"
 #include "timer.h"
+#include "blank_check.h"
 
 /* NAMING CONSTANT DECLARATIONS ------------------------------------------------------ */
 
@@ -204,6 +208,7 @@
 #define _SPI_NAND_LEN_TWO_BYTE			(2)
 #define _SPI_NAND_LEN_THREE_BYTE		(3)
 #define _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET	(6)
+#define _SPI_NAND_PARTIAL_GAP			(8)	/* 0xFF bytes worth a new RANDOM PROGRAM LOAD */
 
 #define _SPI_NAND_OOB_SIZE			256
 #define _SPI_NAND_PAGE_SIZE			(4096 + _SPI_NAND_OOB_SIZE)
@@ -212,6 +217,12 @@
 #define LINUX_USE_OOB_START_OFFSET		4
 #define MAX_LINUX_USE_OOB_SIZE			26
 
+/* MediaTek BMT v1: remap table kept by the Ralink/MediaTek SDK in a pool at the end of flash */
+#define _SPI_NAND_BMT_MAX_SIZE			0x80
+#define _SPI_NAND_BMT_VERSION			1
+#define _SPI_NAND_BMT_HEADER_SIZE		20	/* "BMT", version, bad_count, mapped_count, checksum, reserved[13] */
+#define _SPI_NAND_BMT_ENTRY_SIZE		4	/* u16 bad_index, u16 mapped_index, little endian */
+
 #define EMPTY_DATA				(0)
 #define NONE_EMPTY_DATA				(1)
 #define EMPTY_OOB				(0)
@@ -243,6 +254,8 @@
 
 int ECC_fcheck = 1;
 int ECC_ignore = 0;
+int snand_two_plane = 0;
+int snand_partial_program = 0;
 
 static unsigned char _plane_select_bit = 0;
 static unsigned char _die_id = 0;
@@ -261,6 +274,7 @@ static unsigned long bmt_oob_size = 64;
 static u32 erase_oob_size = 0;
 static u32 ecc_size = 0;
 u32 bsize = 0;
+void (*snand_read_progress)(unsigned long long done) = NULL;
 #if 0
 static unsigned int print_dot = 0;
 #endif
@@ -269,7 +283,27 @@ static u32 _current_page_num = 0xFFFFFFFF;
 static u8 _current_cache_page[_SPI_NAND_CACHE_SIZE];
 static u8 _current_cache_page_data[_SPI_NAND_PAGE_SIZE];
 static u8 _current_cache_page_oob[_SPI_NAND_OOB_SIZE];
-static u8 _current_cache_page_oob_mapping[_SPI_NAND_OOB_SIZE];
+
+/* Logical to physical block map built from the BMT, NULL when BMT mode is off */
+static u32 *_bmt_map = NULL;
+static u32 _bmt_system_blocks = 0;
+
+/* Page held by the chip cache register, so column reads can skip PAGE_READ */
+static u32 _chip_cache_page_num = 0xFFFFFFFF;
+static SPI_NAND_FLASH_RTN_T _chip_cache_page_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
+/* Free OOB bytes of the current chip as runs of physical -> logical offsets */
+struct spi_nand_oob_run {
+	u16	phys;
+	u16	logical;
+	u16	len;
+};
+
+static struct spi_nand_oob_run _oob_runs[SPI_NAND_FLASH_OOB_FREE_ENTRY_MAX];
+static u32 _oob_run_count = 0;
+static u32 _current_page_bitflips = 0;
+static u32 _ecc_corrected_pages = 0;
+static u32 _ecc_max_bitflips = 0;
 
 static struct SPI_NAND_FLASH_INFO_T _current_flash_info_t;	/* Store the current flash information */
 
@@ -486,6 +520,54 @@ struct spi_nand_flash_ooblayout ooblayout_foresee = {
 	.oobfree = {{0,64}}
 };
 
+/* ECC status: 00 no error, 01 corrected, 10 uncorrectable */
+static const struct spi_nand_flash_ecc_status ecc_status_2bit = {
+	.mask = 0x30,
+	.shift = 4,
+	.fail = 0x2,
+	.bitflips = {0, 1, 0, 1}
+};
+
+/* ECC status: 01 1~7 bits corrected, 11 8 bits corrected */
+static const struct spi_nand_flash_ecc_status ecc_status_gigadevice = {
+	.mask = 0x30,
+	.shift = 4,
+	.fail = 0x2,
+	.bitflips = {0, 7, 0, 8}
+};
+
+/* ECC status: 11 corrected and bitflips reached the threshold */
+static const struct spi_nand_flash_ecc_status ecc_status_toshiba = {
+	.mask = 0x30,
+	.shift = 4,
+	.fail = 0x2,
+	.bitflips = {0, 1, 0, 8}
+};
+
+/* ECC status: 001 1~3, 011 4~6, 101 7~8 bits corrected, 010 uncorrectable */
+static const struct spi_nand_flash_ecc_status ecc_status_micron = {
+	.mask = 0x70,
+	.shift = 4,
+	.fail = 0x2,
+	.bitflips = {0, 3, 0, 6, 0, 8, 0, 0}
+};
+
+/* ECC status: 001 1~3, 010~110 4~8 bits corrected, 111 uncorrectable */
+static const struct spi_nand_flash_ecc_status ecc_status_3bit = {
+	.mask = 0x70,
+	.shift = 4,
+	.fail = 0x7,
+	.bitflips = {0, 3, 4, 5, 6, 7, 8, 0}
+};
+
+/* ECC status: 0001~0111 1~7 bits corrected, 1100 8 bits corrected, 1000 uncorrectable */
+static const struct spi_nand_flash_ecc_status ecc_status_xt26g01a = {
+	.mask = 0x3C,
+	.shift = 2,
+	.fail = 0x8,
+	.bitflips = {0, 1, 2, 3, 4, 5, 6, 7, 0, 0, 0, 0, 8, 0, 0, 0}
+};
+
 /*****************************[ Notice]******************************/
 /* If new spi nand chip have page size more than 4KB,  or oob size more than 256 bytes,  than*/
 /* it will need to adjust the #define of _SPI_NAND_PAGE_SIZE and _SPI_NAND_OOB_SIZE */
@@ -504,7 +586,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_gigadevice_a,
+		ecc_status:				&ecc_status_gigadevice,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -519,7 +603,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_gigadevice_128,
+		ecc_status:				&ecc_status_gigadevice,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -534,7 +620,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_gigadevice_128,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -549,7 +637,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_gigadevice_GD5FXGQ4U,
+		ecc_status:				&ecc_status_gigadevice,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -564,7 +654,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_gigadevice_128,
+		ecc_status:				&ecc_status_gigadevice,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -579,7 +671,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type2,
+		ecc_status:				&ecc_status_gigadevice,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -594,7 +688,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_gigadevice_128,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -609,7 +705,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_gigadevice_256,
+		ecc_status:				&ecc_status_gigadevice,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -624,7 +722,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout: 			&ooblayout_gigadevice_256,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -639,6 +739,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_esmt,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -654,6 +755,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_esmt,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -669,6 +771,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_esmt_41lb,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -684,6 +787,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_esmt_41lb,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_DIE_SELECT_1_HAVE,
 	},
 
@@ -699,7 +803,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_winbond,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -714,7 +820,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_winbond,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_DIE_SELECT_1_HAVE,
+		nop:					4,
 	},
 
 	{
@@ -729,7 +837,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_mxic,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -744,7 +854,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_mxic,
-		feature:				SPI_NAND_FLASH_PLANE_SELECT_HAVE,
+		ecc_status:				&ecc_status_2bit,
+		feature:				SPI_NAND_FLASH_PLANE_SELECT_HAVE | SPI_NAND_FLASH_MULTI_PLANE_PROGRAM_HAVE,
+		nop:					4,
 	},
 
 	{
@@ -759,6 +871,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_zentel,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -774,6 +887,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_zentel,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -790,6 +904,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_etron_73C044SNB,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -805,6 +920,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -820,6 +936,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type10,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -835,6 +952,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -850,6 +968,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -865,6 +984,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type18,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -880,6 +1000,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -895,6 +1016,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type10,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -910,6 +1032,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -925,6 +1048,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -940,6 +1064,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_etron_73D044SNA,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -955,6 +1080,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_etron_73D044SNC,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -970,6 +1096,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -985,6 +1112,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type10,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1000,6 +1128,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_etron_73E044SNA,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1015,6 +1144,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout: 			&ooblayout_toshiba_128,
+		ecc_status:				&ecc_status_toshiba,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1030,6 +1160,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout: 			&ooblayout_toshiba_128,
+		ecc_status:				&ecc_status_toshiba,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1045,6 +1176,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout: 			&ooblayout_toshiba_256,
+		ecc_status:				&ecc_status_toshiba,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1060,6 +1192,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout: 			&ooblayout_toshiba_256,
+		ecc_status:				&ecc_status_toshiba,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1075,7 +1208,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_micron,
+		ecc_status:				&ecc_status_micron,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
+		nop:					4,
 	},
 
 	{
@@ -1090,7 +1225,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_micron,
-		feature:				SPI_NAND_FLASH_PLANE_SELECT_HAVE,
+		ecc_status:				&ecc_status_micron,
+		feature:				SPI_NAND_FLASH_PLANE_SELECT_HAVE | SPI_NAND_FLASH_MULTI_PLANE_PROGRAM_HAVE,
+		nop:					4,
 	},
 
 	{
@@ -1105,7 +1242,9 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_micron,
-		feature:				SPI_NAND_FLASH_PLANE_SELECT_HAVE | SPI_NAND_FLASH_DIE_SELECT_2_HAVE,
+		ecc_status:				&ecc_status_micron,
+		feature:				SPI_NAND_FLASH_PLANE_SELECT_HAVE | SPI_NAND_FLASH_DIE_SELECT_2_HAVE | SPI_NAND_FLASH_MULTI_PLANE_PROGRAM_HAVE,
+		nop:					4,
 	},
 
 	{
@@ -1120,6 +1259,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_heyang,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1135,6 +1275,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_heyang,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1150,6 +1291,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type14,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1165,6 +1307,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1180,6 +1323,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1195,6 +1339,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_pn,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1210,6 +1355,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_pn,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1225,6 +1371,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_pn,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1255,6 +1402,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_ato_25D2GA,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1270,6 +1418,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_ato_25D2GB,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1286,6 +1435,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_fm,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1301,6 +1451,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_fm_32,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1316,6 +1467,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_fm,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1331,6 +1483,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_fm,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1346,6 +1499,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_fm_32,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1377,6 +1531,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1392,6 +1547,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type19,
+		ecc_status:				&ecc_status_xt26g01a,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1407,6 +1563,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type19,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1423,6 +1580,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type6,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1439,6 +1597,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type15,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1454,6 +1613,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type10,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1470,6 +1630,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1485,6 +1646,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1500,6 +1662,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1515,6 +1678,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode:				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_type1,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1559,6 +1723,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode: 				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_ds,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_PLANE_SELECT_HAVE,
 	},
 	{
@@ -1573,6 +1738,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode: 				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_ds,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1588,6 +1754,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode: 				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_fison,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 	{
@@ -1602,6 +1769,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode: 				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_fison,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 	{
@@ -1616,6 +1784,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode: 				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_fison,
+		ecc_status:				&ecc_status_3bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 
@@ -1631,6 +1800,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode: 				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_tym,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 	{
@@ -1645,6 +1815,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode: 				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_tym,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 	{
@@ -1659,6 +1830,7 @@ static const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 		read_mode:				SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 		write_mode: 				SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
 		oob_free_layout:			&ooblayout_tym,
+		ecc_status:				&ecc_status_2bit,
 		feature:				SPI_NAND_FLASH_FEATURE_NONE,
 	},
 	// Xincun
@@ -2029,48 +2201,6 @@ static SPI_NAND_FLASH_RTN_T spi_nand_protocol_write_disable( void )
 	return (rtn_status);
 }
 
-/*------------------------------------------------------------------------------------
- * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_protocol_block_erase( u32   block_idx )
- * PURPOSE : To implement the SPI nand protocol for block erase.
- * AUTHOR  :
- * CALLED BY
- *   -
- * CALLS
- *   -
- * PARAMs  :
- *   INPUT : block_idx - The block_idx variable of this function.
- *   OUTPUT: None
- * RETURN  : SPI_RTN_NO_ERROR - Successful.   Otherwise - Failed.
- * NOTES   :
- * MODIFICTION HISTORY:
- *
- *------------------------------------------------------------------------------------
- */
-static SPI_NAND_FLASH_RTN_T spi_nand_protocol_block_erase( u32 block_idx )
-{
-	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-
-	/* 1. Chip Select Low */
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-
-	/* 2. Write op_cmd 0xD8 (Block Erase) */
-	_SPI_NAND_WRITE_ONE_BYTE( _SPI_NAND_OP_BLOCK_ERASE );
-
-	/* 3. Write block number */
-	block_idx = block_idx << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET;	/*Row Address format in SPI NAND chip */
-
-	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_protocol_block_erase : block idx = 0x%x\n", block_idx);
-
-	_SPI_NAND_WRITE_ONE_BYTE( (block_idx >> 16) & 0xff );		/* dummy byte */
-	_SPI_NAND_WRITE_ONE_BYTE( (block_idx >> 8)  & 0xff );
-	_SPI_NAND_WRITE_ONE_BYTE(  block_idx & 0xff );
-
-	/* 4. Chip Select High */
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-
-	return (rtn_status);
-}
-
 /*------------------------------------------------------------------------------------
  * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id( struct SPI_NAND_FLASH_INFO_T *ptr_rtn_flash_id )
  * PURPOSE : To implement the SPI nand protocol for read id.
@@ -2117,91 +2247,6 @@ static SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id ( struct SPI_NAND_FLASH_IN
 	return (rtn_status);
 }
 
-/*------------------------------------------------------------------------------------
- * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id_2( struct SPI_NAND_FLASH_INFO_T *ptr_rtn_flash_id )
- * PURPOSE : To implement the SPI nand protocol for read id.
- * AUTHOR  :
- * CALLED BY
- *   -
- * CALLS
- *   -
- * PARAMs  :
- *   INPUT : None
- *   OUTPUT: None
- * RETURN  : SPI_RTN_NO_ERROR - Successful.   Otherwise - Failed.
- * NOTES   :
- * MODIFICTION HISTORY:
- *
- *------------------------------------------------------------------------------------
- */
-static SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id_2 ( struct SPI_NAND_FLASH_INFO_T *ptr_rtn_flash_id )
-{
-	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-
-	/* 1. Chip Select Low */
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-
-	/* 2. Write op_cmd 0x9F (Read ID) */
-	_SPI_NAND_WRITE_ONE_BYTE( _SPI_NAND_OP_READ_ID );
-
-	/* 3. Read data (Manufacture ID and Device ID) */
-	uint8_t tmp[2];
-	_SPI_NAND_READ_NBYTE(tmp, 2, SPI_CONTROLLER_SPEED_SINGLE);
-
-	ptr_rtn_flash_id->mfr_id = tmp[0];
-	ptr_rtn_flash_id->dev_id = tmp[1];
-
-	/* 4. Chip Select High */
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-
-	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_protocol_read_id_2 : mfr_id = 0x%x, dev_id = 0x%x\n",
-		ptr_rtn_flash_id->mfr_id, ptr_rtn_flash_id->dev_id);
-
-	return (rtn_status);
-}
-
-/*------------------------------------------------------------------------------------
- * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id_3( struct SPI_NAND_FLASH_INFO_T *ptr_rtn_flash_id )
- * PURPOSE : To implement the SPI nand protocol for read id.
- * AUTHOR  :
- * CALLED BY
- *   -
- * CALLS
- *   -
- * PARAMs  :
- *   INPUT : None
- *   OUTPUT: None
- * RETURN  : SPI_RTN_NO_ERROR - Successful.   Otherwise - Failed.
- * NOTES   : Workaround Toshiba/KIOXIA
- * MODIFICTION HISTORY:
- *
- *------------------------------------------------------------------------------------
- */
-static SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id_3 ( struct SPI_NAND_FLASH_INFO_T *ptr_rtn_flash_id )
-{
-	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-	u8 dummy = 0;
-
-	/* 1. Chip Select Low */
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-
-	/* 2. Write op_cmd 0x9F (Read ID) */
-	_SPI_NAND_WRITE_ONE_BYTE( _SPI_NAND_OP_READ_ID );
-
-	/* 3. Read data (Manufacture ID and Device ID) */
-	_SPI_NAND_READ_NBYTE( &dummy, _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
-	_SPI_NAND_READ_NBYTE( &(ptr_rtn_flash_id->mfr_id), _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
-	_SPI_NAND_READ_NBYTE( &(ptr_rtn_flash_id->dev_id), _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
-
-	/* 4. Chip Select High */
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-
-	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_protocol_read_id_3 : dummy = 0x%x, mfr_id = 0x%x, dev_id = 0x%x\n", dummy, ptr_rtn_flash_id->mfr_id, ptr_rtn_flash_id->dev_id);
-
-	return (rtn_status);
-}
-
-
 /*------------------------------------------------------------------------------------
  * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_protocol_page_read( u32    page_number )
  * PURPOSE : To implement the SPI nand protocol for page read.
@@ -2380,8 +2425,8 @@ static SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_from_cache( u32 data_offset,
 	 * Resending the read command for each block to work around the spi
 	 * controller being out of sync.
 	 */
-	for(pos = 0; pos != len; pos += chunksz){
-		rtn_status = _spi_nand_protocol_read_from_cache(pos, chunksz,
+	for(pos = 0; pos < len; pos += chunksz){
+		rtn_status = _spi_nand_protocol_read_from_cache(data_offset + pos, min(chunksz, len - pos),
 				ptr_rtn_buf + pos, read_mode, dummy_mode);
 	}
 
@@ -2420,22 +2465,6 @@ static SPI_NAND_FLASH_RTN_T _spi_nand_protocol_program_load (u32 addr,
 
 	printf("%s: addr = 0x%08x, len = 0x%08x\n", __func__, addr, len );
 
-	/*
-	 * The load program data opcode used causes the cache to be filled
-	 * with 1s. So we don't need to actually transfer sections of the
-	 * page that are all 1s. This reduces the amount of transactions
-	 * we need to do over USB, maybe i2c and maybe spi.
-	 */
-	if(continuation){
-		for(int i = 0; i < len; i++){
-			if(ptr_data[i] != 0xff)
-				goto senddata;
-		}
-		printf("chunk is all ones\n");
-		return rtn_status;
-	}
-
-senddata:
 	/* 1. Chip Select low */
 	_SPI_NAND_READ_CHIP_SELECT_LOW();
 #if 0
@@ -2512,7 +2541,20 @@ static SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_load(u32 addr,
 	int chunksz = 128;
 	int pos;
 
+	/* PROGRAM LOAD overwrites the cache register */
+	_chip_cache_page_num = 0xFFFFFFFF;
+
 	for(pos = 0; pos != len; pos += min(len - pos, chunksz)){
+		/*
+		 * The load program data opcode used causes the cache to be filled
+		 * with 1s. So we don't need to actually transfer sections of the
+		 * page that are all 1s. This reduces the amount of transactions
+		 * we need to do over USB, maybe i2c and maybe spi.
+		 */
+		if(pos != 0 && mem_is_blank(ptr_data + pos, min(len - pos, chunksz))){
+			printf("chunk is all ones\n");
+			continue;
+		}
 		rtn_status = _spi_nand_protocol_program_load(pos, ptr_data + pos,
 				min(len - pos, chunksz),write_mode, pos != 0);
 	}
@@ -2520,6 +2562,24 @@ static SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_load(u32 addr,
 	return (rtn_status);
 }
 
+/* Load a whole page with random load only, keeping the rest of the cache untouched */
+static SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_load_random(u8 *ptr_data, u32 len, u32 write_mode)
+{
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+	int chunksz = 128;
+	int pos;
+
+	_chip_cache_page_num = 0xFFFFFFFF;
+
+	/* The cache was not reset to 1s, so every chunk has to be sent */
+	for(pos = 0; pos != len; pos += min(len - pos, chunksz)){
+		rtn_status = _spi_nand_protocol_program_load(pos, ptr_data + pos,
+				min(len - pos, chunksz), write_mode, true);
+	}
+
+	return (rtn_status);
+}
+
 /*------------------------------------------------------------------------------------
  * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_execute( u32  addr )
  * PURPOSE : To implement the SPI nand protocol for program execute.
@@ -2604,6 +2664,38 @@ static SPI_NAND_FLASH_RTN_T spi_nand_protocol_die_select_2( u8 die_id)
 	return (rtn_status);
 }
 
+/* Page number bit which selects the die (0 for single die chips) */
+static u32 spi_nand_die_page_shift ( void )
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	if( ((ptr_dev_info_t->feature) & SPI_NAND_FLASH_DIE_SELECT_1_HAVE) ) {
+		/* single die = 1024blocks * 64pages */
+		return 16;
+	} else if( ((ptr_dev_info_t->feature) & SPI_NAND_FLASH_DIE_SELECT_2_HAVE) ) {
+		/* single die = 2plans * 1024blocks * 64pages */
+		return 17;
+	}
+
+	return 0;
+}
+
+static u8 spi_nand_die_count ( void )
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	u32 shift;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+	shift = spi_nand_die_page_shift();
+
+	if( (shift == 0) || (ptr_dev_info_t->page_size == 0) )
+		return 1;
+
+	return (u8)(((ptr_dev_info_t->device_size / ptr_dev_info_t->page_size) >> shift) ? : 1);
+}
+
 static void spi_nand_select_die ( u32 page_number )
 {
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
@@ -2612,8 +2704,7 @@ static void spi_nand_select_die ( u32 page_number )
 	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
 
 	if( ((ptr_dev_info_t->feature) & SPI_NAND_FLASH_DIE_SELECT_1_HAVE) ) {
-		/* single die = 1024blocks * 64pages */
-		die_id = ((page_number >> 16) & 0xff);
+		die_id = ((page_number >> spi_nand_die_page_shift()) & 0xff);
 
 		if (_die_id != die_id)
 		{
@@ -2623,8 +2714,7 @@ static void spi_nand_select_die ( u32 page_number )
 			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_protocol_die_select_1: die_id=0x%x\n", die_id);
 		}
 	} else if( ((ptr_dev_info_t->feature) & SPI_NAND_FLASH_DIE_SELECT_2_HAVE) ) {
-		/* single die = 2plans * 1024blocks * 64pages */
-		die_id = ((page_number >> 17) & 0xff);
+		die_id = ((page_number >> spi_nand_die_page_shift()) & 0xff);
 
 		if (_die_id != die_id)
 		{
@@ -2638,270 +2728,90 @@ static void spi_nand_select_die ( u32 page_number )
 
 static SPI_NAND_FLASH_RTN_T ecc_fail_check( u32 page_number )
 {
-	u8 status;
-	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
-	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+	u8 status, value;
+	const struct spi_nand_flash_ecc_status *ecc;
+
+	ecc = _current_flash_info_t.ecc_status;
+	_current_page_bitflips = 0;
+
+	if( ecc == NULL )
+		return (SPI_NAND_FLASH_RTN_NO_ERROR);
 
 	spi_nand_protocol_get_status_reg_3( &status);
 
 	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "ecc_fail_check: status = 0x%x\n", status);
 
-	if((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_GIGADEVICE) &&
-		((ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F1GQ4UAYIG) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F1GQ4UBYIG) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F1GQ4UCYIG) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F1GQ4UEYIS) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F2GQ4UBYIG) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F2GQ4UE9IS) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F2GQ4UCYIG) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F4GQ4UBYIG) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F4GQ4UCYIG)))
-	{
-		if((ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F1GQ4UAYIG) ||
-			(ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F1GQ4UBYIG) ||
-			(ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F1GQ4UEYIS) ||
-			(ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F2GQ4UBYIG) ||
-			(ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F2GQ4UE9IS) ||
-			(ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F4GQ4UBYIG))
-		{
-			if(((status & 0x30) >> 4) == 0x2 )
-			{
-				rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-			}
-		}
-
-		if((ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F1GQ4UCYIG) ||
-			(ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F2GQ4UCYIG) ||
-			(ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_GD5F4GQ4UCYIG))
-		{
-			if(((status & 0x70) >> 4) == 0x7)
-			{
-				rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-			}
-		}
-	}
-	else if(ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_MXIC)
-	{
-		if(((status & 0x30) >> 4) == 0x2 )
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if(ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_WINBOND)
-	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_ESMT) &&
-		((ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_F50L512M41A) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_F50L1G41A0) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_F50L1G41LB) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_F50L2G41LB)))
+	value = (status & ecc->mask) >> ecc->shift;
+	if( value == ecc->fail )
 	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_ZENTEL) &&
-		((ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_A5U12A21ASC) ||
-		 (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_A5U1GA21BWS)))
-	{
-		if(((status & 0x30) >> 4) == 0x2 )
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
+		_SPI_NAND_PRINTF("[spinand_ecc_fail_check] : ECC cannot recover detected !, page = 0x%x\n", page_number);
+		return (SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK);
 	}
-	else if(ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_ETRON)
+
+	_current_page_bitflips = ecc->bitflips[value & 0xF];
+	if( _current_page_bitflips )
 	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
+		_ecc_corrected_pages++;
+		if( _current_page_bitflips > _ecc_max_bitflips )
+			_ecc_max_bitflips = _current_page_bitflips;
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "ecc_fail_check: page = 0x%x, %u bitflips corrected\n", page_number, _current_page_bitflips);
 	}
-	else if(ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_TOSHIBA)
+
+	return (SPI_NAND_FLASH_RTN_NO_ERROR);
+}
+
+/*------------------------------------------------------------------------------------
+ * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_load_page_into_cache( long  page_number )
+ * PURPOSE : To load page into SPI NAND chip.
+ * AUTHOR  :
+ * CALLED BY
+ *   -
+ * CALLS
+ *   -
+ * PARAMs  :
+ *   INPUT : page_number - The page_number variable of this function.
+ *   OUTPUT: None
+ * RETURN  : SPI_RTN_NO_ERROR - Successful.   Otherwise - Failed.
+ * NOTES   :
+ * MODIFICTION HISTORY:
+ *
+ *------------------------------------------------------------------------------------
+ */
+static SPI_NAND_FLASH_RTN_T spi_nand_load_page_into_cache( u32 page_number)
+{
+	u8 status;
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_load_page_into_cache: page number = 0x%x\n", page_number);
+
+	if( _current_page_num == page_number )
 	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_load_page_into_cache: page number == _current_page_num\n");
 	}
-	else if(ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_MICRON)
+	else if( _chip_cache_page_num == page_number )
 	{
-		if(((status & 0x70) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
+		spi_nand_select_die ( page_number );
+		rtn_status = _chip_cache_page_status;
 	}
-	else if(ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_HEYANG)
+	else
 	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if(((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_PN) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_PN26G01AWSIUG)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_PN) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_PN26G02AWSIUG)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_PN) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_PN26Q01AWSIUG)))
-	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if(((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_ATO) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_ATO25D2GA)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_ATO_2) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_ATO25D2GB)))
-	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if(((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FM) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_FM25S01)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FM) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_FM25S01A)))
-	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if(((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FM) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_FM25G01B)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FM) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_FM25G02B)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FM) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_FM25G02C)))
-	{
-		if(((status & 0x70) >> 4) == 0x7)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if(((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_XTX) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_XT26G02B)))
-	{
-		if(((status & 0x70) >> 4) == 0x7)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if (((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_XTX) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_XT26G01A)))
-	{
-		if(((status & 0x3C) >> 2) == 0x8)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if (((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_XTX) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_XT26G02A)))
-	{
-		if(((status & 0x30) >> 4) == 0x2 )
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if(((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_MIRA) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_PSU1GS20BN)))
-	{
-		if(((status & 0x30) >> 4) == 0x2 )
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if (((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_BIWIN) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_BWJX08U)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_BIWIN) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_BWET08U)))
-	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if (((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FORESEE) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_FS35ND02GS2F1)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FORESEE) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_FS35ND02GD1F1)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FORESEE) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_FS35ND01GS1F1)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FORESEE) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_FS35ND01GD1F1)))
-	{
-		if(((status & 0x70) >> 4) == 0x7)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if(((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_DS) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_DS35Q2GA)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_DS) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_DS35Q1GA)))
-	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if(((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FISON) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_CS11G0T0A0AA)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FISON) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_CS11G1T0A0AA)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_FISON) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_CS11G0G0A0AA)))
-	{
-		if(((status & 0x70) >> 4) == 0x7)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-	else if(((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_TYM) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_TYM25D2GA01)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_TYM) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_TYM25D2GA02)) ||
-		((ptr_dev_info_t->mfr_id == _SPI_NAND_MANUFACTURER_ID_TYM) && (ptr_dev_info_t->dev_id == _SPI_NAND_DEVICE_ID_TYM25D1GA03)))
-	{
-		if(((status & 0x30) >> 4) == 0x2)
-		{
-			rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-		}
-	}
-
-	if(rtn_status == SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK)
-	{
-		_SPI_NAND_PRINTF("[spinand_ecc_fail_check] : ECC cannot recover detected !, page = 0x%x\n", page_number);
-	}
-
-	return (rtn_status);
-}
-
-/*------------------------------------------------------------------------------------
- * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_load_page_into_cache( long  page_number )
- * PURPOSE : To load page into SPI NAND chip.
- * AUTHOR  :
- * CALLED BY
- *   -
- * CALLS
- *   -
- * PARAMs  :
- *   INPUT : page_number - The page_number variable of this function.
- *   OUTPUT: None
- * RETURN  : SPI_RTN_NO_ERROR - Successful.   Otherwise - Failed.
- * NOTES   :
- * MODIFICTION HISTORY:
- *
- *------------------------------------------------------------------------------------
- */
-static SPI_NAND_FLASH_RTN_T spi_nand_load_page_into_cache( u32 page_number)
-{
-	u8 status;
-	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-
-	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_load_page_into_cache: page number = 0x%x\n", page_number);
-
-	if( _current_page_num == page_number )
-	{
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_load_page_into_cache: page number == _current_page_num\n");
-	}
-	else
-	{
-		spi_nand_select_die ( page_number );
-
-		spi_nand_protocol_page_read ( page_number );
-
-		/*  Checking status for load page/erase/program complete */
-		do {
-			spi_nand_protocol_get_status_reg_3( &status);
-		} while( status & _SPI_NAND_VAL_OIP) ;
-
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_load_page_into_cache : status = 0x%x\n", status);
-		if (ECC_fcheck && !ECC_ignore)
-			rtn_status = ecc_fail_check(page_number);
-		else
-			rtn_status = 0;
+		spi_nand_select_die ( page_number );
+
+		spi_nand_protocol_page_read ( page_number );
+
+		/*  Checking status for load page/erase/program complete */
+		do {
+			spi_nand_protocol_get_status_reg_3( &status);
+		} while( status & _SPI_NAND_VAL_OIP) ;
+
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_load_page_into_cache : status = 0x%x\n", status);
+		if (ECC_fcheck && !ECC_ignore)
+			rtn_status = ecc_fail_check(page_number);
+		else
+			rtn_status = 0;
+
+		_chip_cache_page_num = page_number;
+		_chip_cache_page_status = rtn_status;
 	}
 
 	return (rtn_status);
@@ -2945,68 +2855,374 @@ static void spi_nand_set_clock_speed( u32 clk)
  *
  *------------------------------------------------------------------------------------
  */
-static SPI_NAND_FLASH_RTN_T spi_nand_block_aligned_check( u32 addr, u32 len )
+static SPI_NAND_FLASH_RTN_T spi_nand_block_aligned_check( u64 addr, u64 len )
 {
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 
 	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR ;
 
-	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "SPI_NAND_BLOCK_ALIGNED_CHECK_check: addr = 0x%x, len = 0x%x, block size = 0x%x \n", addr, len, (ptr_dev_info_t->erase_size));
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "SPI_NAND_BLOCK_ALIGNED_CHECK_check: addr = 0x%llx, len = 0x%llx, block size = 0x%x \n", addr, len, (ptr_dev_info_t->erase_size));
 
 	if (_SPI_NAND_BLOCK_ALIGNED_CHECK(len, (ptr_dev_info_t->erase_size))) 
 	{
 		len = ( (len/ptr_dev_info_t->erase_size) + 1) * (ptr_dev_info_t->erase_size);
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "SPI_NAND_BLOCK_ALIGNED_CHECK_check: erase block aligned first check OK, addr:%x len:%x\n", addr, len, (ptr_dev_info_t->erase_size));
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "SPI_NAND_BLOCK_ALIGNED_CHECK_check: erase block aligned first check OK, addr:%llx len:%llx\n", addr, len, (ptr_dev_info_t->erase_size));
 	}
 
 	if (_SPI_NAND_BLOCK_ALIGNED_CHECK(addr, (ptr_dev_info_t->erase_size)) || _SPI_NAND_BLOCK_ALIGNED_CHECK(len, (ptr_dev_info_t->erase_size)) ) 
 	{
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "SPI_NAND_BLOCK_ALIGNED_CHECK_check: erase block not aligned, addr:0x%x len:0x%x, blocksize:0x%x\n", addr, len, (ptr_dev_info_t->erase_size));
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "SPI_NAND_BLOCK_ALIGNED_CHECK_check: erase block not aligned, addr:0x%llx len:0x%llx, blocksize:0x%x\n", addr, len, (ptr_dev_info_t->erase_size));
 		rtn_status = SPI_NAND_FLASH_RTN_ALIGNED_CHECK_FAIL;
 	}
 
 	return (rtn_status);
 }
 
+#define _SPI_NAND_TBERS_US		3000	/* typical block erase time, seeds the poll schedule */
+#define _SPI_NAND_TBERS_MIN_US		500
+#define _SPI_NAND_TBERS_MAX_US		10000
+
+/* Wait before the first status poll, follows the erase time of the chip */
+static u32 _erase_wait_us = _SPI_NAND_TBERS_US;
+
+/* One bit per block which failed in the last erase */
+static u8 *_erase_fail_map = NULL;
+static u32 _erase_fail_count = 0;
+static u32 _erase_skip_count = 0;
+
+static SPI_NAND_FLASH_RTN_T spi_nand_read_page (u32 page_number, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode);
+
+/*
+ * A block needs no erase only if every page reads back all ones, spare area
+ * included. Writes skip blank pages, so the first and last pages say
+ * nothing about the ones in between.
+ */
+static bool spi_nand_block_is_blank( u32 block_index )
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	u32 page_number = block_index << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET;
+	u32 pages = 1 << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET;
+	u32 i;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	for( i = 0; i < pages; i++ )
+	{
+		if( spi_nand_read_page(page_number + i, ptr_dev_info_t->read_mode) != SPI_NAND_FLASH_RTN_NO_ERROR )
+			return false;
+		if( !mem_is_blank(&_current_cache_page[0], (ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)) )
+			return false;
+	}
+
+	return true;
+}
+
+static void spi_nand_erase_mark_fail( u32 block_index )
+{
+	u32 blocks = _current_flash_info_t.device_size / _current_flash_info_t.erase_size;
+
+	if( !_erase_fail_map )
+		_erase_fail_map = calloc( (blocks + 7) / 8, 1 );
+
+	if( _erase_fail_map && (block_index < blocks) )
+		_erase_fail_map[block_index >> 3] |= (1 << (block_index & 7));
+
+	_erase_fail_count++;
+}
+
+static void spi_nand_erase_progress( u64 erase_len, u64 len )
+{
+	static int last_percent = -1;
+	int percent = 100 * (erase_len / 1024) / (len / 1024);
+
+	if( erase_len == 0 )
+		last_percent = -1;
+	if( percent == last_percent )
+		return;
+	last_percent = percent;
+
+	printf("\bErase %d%% [%llu] of [%llu] bytes      ", percent, erase_len, len);
+	printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+	fflush(stdout);
+}
+
+/*
+ * Programs issued to each page since its block was last erased. Pages not
+ * erased during this run are assumed to have been programmed once already.
+ */
+static u8 *_nop_count = NULL;
+
+static bool spi_nand_nop_take( u32 page_number )
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	u32 pages, nop;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+	nop = ptr_dev_info_t->nop ? ptr_dev_info_t->nop : 1;
+
+	if( _nop_count == NULL )
+	{
+		pages = ptr_dev_info_t->device_size / ptr_dev_info_t->page_size;
+		_nop_count = (u8 *)malloc(pages);
+		if( _nop_count == NULL )
+			return true;
+		memset(_nop_count, 1, pages);
+	}
+
+	if( _nop_count[page_number] >= nop )
+		return false;
+
+	_nop_count[page_number]++;
+
+	return true;
+}
+
+static void spi_nand_nop_reset( u32 block_index )
+{
+	if( _nop_count )
+		memset(&_nop_count[block_index << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET], 0, 1 << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET);
+}
+
+/* WRITE ENABLE, BLOCK ERASE and the first status read go out in one submission */
+static SPI_NAND_FLASH_RTN_T spi_nand_erase_block_submit( u32 block_index, u8 *status )
+{
+	u32 row = block_index << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET;
+	u8 cmd_wren[1] = { _SPI_NAND_OP_WRITE_ENABLE };
+	u8 cmd_erase[4] = { _SPI_NAND_OP_BLOCK_ERASE, (row >> 16) & 0xff, (row >> 8) & 0xff, row & 0xff };
+	u8 cmd_status[2] = { _SPI_NAND_OP_GET_FEATURE, _SPI_NAND_ADDR_STATUS };
+	struct spi_transfer xfers[3] = {
+		{ sizeof(cmd_wren), 0, cmd_wren, NULL },
+		{ sizeof(cmd_erase), 0, cmd_erase, NULL },
+		{ sizeof(cmd_status), 1, cmd_status, status },
+	};
+
+	spi_nand_select_die( row );
+	_chip_cache_page_num = 0xFFFFFFFF;
+	spi_nand_nop_reset( block_index );
+
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_erase_block_submit : block idx = 0x%x\n", block_index);
+
+	if( SPI_CONTROLLER_Send_Batch(xfers, 3) != SPI_CONTROLLER_RTN_NO_ERROR )
+	{
+		*status = _SPI_NAND_VAL_ERASE_FAIL;
+		return SPI_NAND_FLASH_RTN_ERASE_FAIL;
+	}
+
+	return SPI_NAND_FLASH_RTN_NO_ERROR;
+}
+
 SPI_NAND_FLASH_RTN_T spi_nand_erase_block ( u32 block_index)
 {
 	u8 status;
+	u32 polls = 0;
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 
-	spi_nand_select_die ( (block_index << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET) );
+	/* 2.1 Enable write, erase one block and read the status at once */
+	spi_nand_erase_block_submit( block_index, &status );
 
-	/* 2.2 Enable write_to flash */
-	spi_nand_protocol_write_enable();
+	/* 2.2 Sleep for about tBERS, then poll until the erase completes */
+	if( status & _SPI_NAND_VAL_OIP )
+	{
+		usleep( _erase_wait_us );
+		spi_nand_protocol_get_status_reg_3( &status );
+		while( status & _SPI_NAND_VAL_OIP )
+		{
+			polls++;
+			spi_nand_protocol_get_status_reg_3( &status );
+		}
 
-	/* 2.3 Erasing one block */
-	spi_nand_protocol_block_erase( block_index );
+		/* 2.3 Follow the erase time of this chip */
+		if( polls )
+			_erase_wait_us = min(_erase_wait_us + _erase_wait_us / 8, _SPI_NAND_TBERS_MAX_US);
+		else
+			_erase_wait_us = max(_erase_wait_us - _erase_wait_us / 16, _SPI_NAND_TBERS_MIN_US);
+	}
 
-	/* 2.4 Checking status for erase complete */
-	do {
-		spi_nand_protocol_get_status_reg_3( &status);
-	} while( status & _SPI_NAND_VAL_OIP) ;
+	/* WEL is cleared by the chip once the erase completes */
+
+	/* 2.4 Check Erase Fail Bit */
+	if( status & _SPI_NAND_VAL_ERASE_FAIL )
+	{
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_erase_block : erase block fail, block = 0x%x, status = 0x%x\n", block_index, status);
+		spi_nand_erase_mark_fail( block_index );
+		rtn_status = SPI_NAND_FLASH_RTN_ERASE_FAIL;
+	}
+
+	return rtn_status;
+}
+
+/*
+ * Stacked chips (W25M02GV, MT29F4G01, ...) run each die independently, so a
+ * block erase issued on one die may proceed while the other die is being
+ * addressed. Jobs are started round robin over the dies and every die is
+ * polled on its own, with _die_id tracking the die the chip currently has
+ * selected.
+ */
+struct spi_nand_die_job {
+	u64	next;		/* next block (erase) or address (program) to start */
+	u64	end;		/* end of the range which belongs to this die */
+	u32	busy_page;	/* page of the operation in flight */
+	u32	busy_len;	/* bytes accounted when the operation completes */
+	u32	busy_offset;
+	bool	busy;
+};
+
+#define _SPI_NAND_MAX_DIE	4
+
+static u32 spi_nand_die_jobs_init( struct spi_nand_die_job *jobs, u64 start, u64 end, u64 unit_per_die )
+{
+	u32 die, die_num;
+
+	die_num = spi_nand_die_count();
+	if( die_num > _SPI_NAND_MAX_DIE )
+		die_num = _SPI_NAND_MAX_DIE;
+
+	for( die = 0; die < die_num; die++ )
+	{
+		jobs[die].next = max(start, die * unit_per_die);
+		jobs[die].end = min(end, (die + 1) * unit_per_die);
+		if( jobs[die].next >= jobs[die].end )
+			jobs[die].next = jobs[die].end = 0;
+		jobs[die].busy = false;
+	}
+
+	return die_num;
+}
+
+/* Translate a logical address through the BMT, blocks outside the system area are not remapped */
+static u64 spi_nand_bmt_map_addr( u64 addr )
+{
+	u32 block;
+
+	if( _bmt_map == NULL )
+		return addr;
+
+	block = addr / _current_flash_info_t.erase_size;
+	if( block >= _bmt_system_blocks )
+		return addr;
+
+	return ((u64)_bmt_map[block] * _current_flash_info_t.erase_size) + (addr % _current_flash_info_t.erase_size);
+}
+
+static bool spi_nand_range_spans_dies( u64 addr, u64 len )
+{
+	u32 shift = spi_nand_die_page_shift();
+	u32 page_size = _current_flash_info_t.page_size;
+
+	/* Remapped blocks do not follow the die layout */
+	if( (shift == 0) || (len == 0) || (spi_nand_die_count() < 2) || _bmt_map )
+		return false;
+
+	return ((addr / page_size) >> shift) != (((addr + len - 1) / page_size) >> shift);
+}
+
+static bool spi_nand_die_job_poll( struct spi_nand_die_job *job, u8 *status )
+{
+	spi_nand_select_die( job->busy_page );
+	spi_nand_protocol_get_status_reg_3( status );
+
+	if( *status & _SPI_NAND_VAL_OIP )
+		return false;
 
-	/* 2.5 Disable write_flash */
 	spi_nand_protocol_write_disable();
+	job->busy = false;
 
-#if 0
-	print_dot++;
-	if( (print_dot % 15) == 0 )
+	return true;
+}
+
+static SPI_NAND_FLASH_RTN_T spi_nand_erase_interleaved( u64 addr, u64 len )
+{
+	struct spi_nand_die_job jobs[_SPI_NAND_MAX_DIE];
+	u32 die, die_num;
+	u64 erase_len = 0;
+	u32 blocks_per_die, block_size;
+	u8 status;
+	bool pending = true;
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
+	block_size = _current_flash_info_t.erase_size;
+	blocks_per_die = (1 << spi_nand_die_page_shift()) >> _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET;
+	die_num = spi_nand_die_jobs_init( jobs, addr / block_size, (addr + len) / block_size, blocks_per_die );
+
+	while( pending )
 	{
-		_SPI_NAND_PRINTF(".");
-		fflush(stdout);
+		pending = false;
+
+		for( die = 0; die < die_num; die++ )
+		{
+			struct spi_nand_die_job *job = &jobs[die];
+
+			if( job->busy )
+			{
+				if( !spi_nand_die_job_poll(job, &status) )
+				{
+					pending = true;
+					continue;
+				}
+
+				if( status & _SPI_NAND_VAL_ERASE_FAIL )
+				{
+					spi_nand_erase_mark_fail( job->busy_page >> _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET );
+					rtn_status = SPI_NAND_FLASH_RTN_ERASE_FAIL;
+				}
+
+				erase_len += block_size;
+				spi_nand_erase_progress( erase_len, len );
+			}
+
+			/* Blank blocks are checked while the other dies are busy erasing */
+			while( flash_erase_skip_blank && (job->next < job->end) && spi_nand_block_is_blank(job->next) )
+			{
+				_erase_skip_count++;
+				job->next++;
+				erase_len += block_size;
+				spi_nand_erase_progress( erase_len, len );
+			}
+
+			if( job->next < job->end )
+			{
+				job->busy_page = job->next << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET;
+				spi_nand_erase_block_submit( job->next, &status );
+				job->next++;
+				job->busy = true;
+				pending = true;
+			}
+		}
 	}
-#endif
+	printf("Erase 100%% [%llu] of [%llu] bytes      \n", erase_len, len);
 
-	/* 2.6 Check Erase Fail Bit */
-	if( status & _SPI_NAND_VAL_ERASE_FAIL )
+	return (rtn_status);
+}
+
+static void spi_nand_erase_report( void )
+{
+	u32 block, blocks;
+
+	/* The software cache may hold pages read by the blank check */
+	SPI_NAND_Flash_Clear_Read_Cache_Data();
+
+	if( _erase_skip_count )
+		_SPI_NAND_PRINTF("Skipped %u blank blocks\n", _erase_skip_count);
+
+	if( !_erase_fail_count )
+		return;
+
+	_SPI_NAND_PRINTF("Erase failed on %u blocks:", _erase_fail_count);
+	blocks = _current_flash_info_t.device_size / _current_flash_info_t.erase_size;
+	for( block = 0; _erase_fail_map && (block < blocks); block++ )
 	{
-		_SPI_NAND_PRINTF("spi_nand_erase_block : erase block fail, block = 0x%x, status = 0x%x\n", block_index, status);
-		rtn_status = SPI_NAND_FLASH_RTN_ERASE_FAIL;
+		if( _erase_fail_map[block >> 3] & (1 << (block & 7)) )
+			_SPI_NAND_PRINTF(" 0x%x", block);
 	}
+	_SPI_NAND_PRINTF("\n");
+}
 
-	return rtn_status;
+u32 SPI_NAND_Flash_Get_Erase_Fail_Map( const u8 **ptr_rtn_map )
+{
+	*ptr_rtn_map = _erase_fail_map;
+
+	return _erase_fail_count;
 }
 
 /*------------------------------------------------------------------------------------
@@ -3028,16 +3244,16 @@ SPI_NAND_FLASH_RTN_T spi_nand_erase_block ( u32 block_index)
  *
  *------------------------------------------------------------------------------------
  */
-static SPI_NAND_FLASH_RTN_T spi_nand_erase_internal( u32 addr, u32 len )
+static SPI_NAND_FLASH_RTN_T spi_nand_erase_internal( u64 addr, u64 len )
 {
 	u32 block_index = 0;
-	u32 erase_len = 0;
+	u64 erase_len = 0;
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 #if 0
 	print_dot  = 0;
 #endif
 
-	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "\nspi_nand_erase_internal (in): addr = 0x%x, len = 0x%x\n", addr, len );
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "\nspi_nand_erase_internal (in): addr = 0x%llx, len = 0x%llx\n", addr, len );
 	_SPI_NAND_SEMAPHORE_LOCK();
 
 	/* Switch to manual mode*/
@@ -3045,34 +3261,45 @@ static SPI_NAND_FLASH_RTN_T spi_nand_erase_internal( u32 addr, u32 len )
 
 	SPI_NAND_Flash_Clear_Read_Cache_Data();
 
+	if( _erase_fail_map )
+		memset( _erase_fail_map, 0, (_current_flash_info_t.device_size / _current_flash_info_t.erase_size + 7) / 8 );
+	_erase_fail_count = 0;
+	_erase_skip_count = 0;
+	spi_nand_erase_progress( 0, len );
+
 	/* 1. Check the address and len must aligned to NAND Flash block size */
 	if( spi_nand_block_aligned_check( addr, len) == SPI_NAND_FLASH_RTN_NO_ERROR)
 	{
-		/* 2. Erase block one by one */
+		/* 2. Stacked dies erase in parallel */
+		if( spi_nand_range_spans_dies(addr, len) )
+		{
+			rtn_status = spi_nand_erase_interleaved( addr, len );
+			spi_nand_erase_report();
+			_SPI_NAND_SEMAPHORE_UNLOCK();
+			return (rtn_status);
+		}
+
+		/* 3. Erase block one by one */
 		while( erase_len < len )
 		{
 			/* 2.1 Caculate Block index */
-			block_index = (addr/(_current_flash_info_t.erase_size));
+			block_index = (spi_nand_bmt_map_addr(addr)/(_current_flash_info_t.erase_size));
 
-			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_erase_internal: addr = 0x%x, len = 0x%x, block_idx = 0x%x\n", addr, len, block_index );
+			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_erase_internal: addr = 0x%llx, len = 0x%llx, block_idx = 0x%x\n", addr, len, block_index );
 
-			rtn_status = spi_nand_erase_block(block_index);
-
-			/* 2.6 Check Erase Fail Bit */
-			if(rtn_status != SPI_NAND_FLASH_RTN_NO_ERROR)
-			{
-				_SPI_NAND_PRINTF("spi_nand_erase_internal : Erase Fail at addr = 0x%x, len = 0x%x, block_idx = 0x%x\n", addr, len, block_index);
+			/* 2.6 Failed blocks are recorded, keep erasing the rest */
+			if( flash_erase_skip_blank && spi_nand_block_is_blank(block_index) )
+				_erase_skip_count++;
+			else if( spi_nand_erase_block(block_index) != SPI_NAND_FLASH_RTN_NO_ERROR )
 				rtn_status = SPI_NAND_FLASH_RTN_ERASE_FAIL;
-			}
 
 			/* 2.7 Erase next block if needed */
 			addr		+= _current_flash_info_t.erase_size;
 			erase_len	+= _current_flash_info_t.erase_size;
-			printf("\bErase %d%% [%u] of [%u] bytes      ", 100 * (erase_len / 1024) / (len / 1024), erase_len, len);
-			printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
-			fflush(stdout);
+			spi_nand_erase_progress( erase_len, len );
 		}
-		printf("Erase 100%% [%u] of [%u] bytes      \n", erase_len, len);
+		printf("Erase 100%% [%llu] of [%llu] bytes      \n", erase_len, len);
+		spi_nand_erase_report();
 	}
 	else
 	{
@@ -3084,14 +3311,49 @@ static SPI_NAND_FLASH_RTN_T spi_nand_erase_internal( u32 addr, u32 len )
 	return 	(rtn_status);
 }
 
+/* Flatten the chip OOB free layout into copy runs, once after probe */
+static void spi_nand_compile_oob_layout( void )
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	const struct spi_nand_flash_ooblayout *ptr_layout;
+	u32 i, len, idx = 0;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+	ptr_layout = ptr_dev_info_t->oob_free_layout;
+	_oob_run_count = 0;
+
+	if( _ondie_ecc_flag != 1 )
+	{
+		/* no mapping without on-die ECC */
+		if( ptr_dev_info_t->oob_size )
+		{
+			_oob_runs[0].phys = 0;
+			_oob_runs[0].logical = 0;
+			_oob_runs[0].len = ptr_dev_info_t->oob_size;
+			_oob_run_count = 1;
+		}
+		return;
+	}
+
+	for( i = 0; (i < SPI_NAND_FLASH_OOB_FREE_ENTRY_MAX) && (ptr_layout->oobfree[i].len) && (idx < ptr_layout->oobsize); i++ )
+	{
+		len = min(ptr_layout->oobfree[i].len, ptr_layout->oobsize - idx);
+		if( ptr_layout->oobfree[i].offset + len > _SPI_NAND_OOB_SIZE )
+			break;
+
+		_oob_runs[_oob_run_count].phys = ptr_layout->oobfree[i].offset;
+		_oob_runs[_oob_run_count].logical = idx;
+		_oob_runs[_oob_run_count].len = len;
+		_oob_run_count++;
+		idx += len;
+	}
+}
+
 static SPI_NAND_FLASH_RTN_T spi_nand_read_page (u32 page_number, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode)
 {
 
-	u32 idx = 0;
-	u32 i, j;
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-	struct spi_nand_flash_oobfree *ptr_oob_entry_idx;
 	u16 read_addr;
 
 	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
@@ -3115,8 +3377,6 @@ static SPI_NAND_FLASH_RTN_T spi_nand_read_page (u32 page_number, SPI_NAND_FLASH_
 	/* No matter what status, we must read the cache data to dram */
 	if((_current_page_num != page_number))
 	{
-		memset(_current_cache_page, 0x0, sizeof(_current_cache_page)); 
-
 		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: before read, _current_cache_page:\n");
 		_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page[0], _SPI_NAND_CACHE_SIZE);
 		
@@ -3141,32 +3401,10 @@ static SPI_NAND_FLASH_RTN_T spi_nand_read_page (u32 page_number, SPI_NAND_FLASH_
 				goto noecc;
 			memcpy( &_current_cache_page_oob[0],  &_current_cache_page[(ptr_dev_info_t->page_size)], (ptr_dev_info_t->oob_size) );
 
-			idx = 0;
-			ptr_oob_entry_idx = (struct spi_nand_flash_oobfree*) &( (ptr_dev_info_t->oob_free_layout)->oobfree );
-
-			if( _ondie_ecc_flag == 1)   /*  When OnDie ecc is enable,  mapping oob area is neccessary */
-			{
-				/* Transter oob area from physical offset into logical offset */
-				for( i = 0; (i < SPI_NAND_FLASH_OOB_FREE_ENTRY_MAX) && (ptr_oob_entry_idx[i].len) && (idx < ((ptr_dev_info_t->oob_free_layout)->oobsize)) ; i++)
-				{
-					for(j = 0; (j < (ptr_oob_entry_idx[i].len)) && (idx < (ptr_dev_info_t->oob_free_layout->oobsize)) ; j++)
-					{
-						/* _SPI_NAND_PRINTF("i=%d , j=%d, len=%d, idx=%d, size=%d\n", i, j,(ptr_oob_entry_idx[i].len), idx, (ptr_dev_info_t->oob_free_layout->oobsize) ); */
-						_current_cache_page_oob_mapping[idx] = _current_cache_page_oob[(ptr_oob_entry_idx[i].offset)+j];
-						idx++;
-					}
-				}
-			}
-			else
-			{
-				memcpy( &_current_cache_page_oob_mapping[0],  &_current_cache_page_oob[0], (ptr_dev_info_t->oob_size) );
-			}
 			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: _current_cache_page:\n");
 			_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page[0], ((ptr_dev_info_t->page_size)+(ptr_dev_info_t->oob_size)));
 			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: _current_cache_page_oob:\n");
 			_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page_oob[0], (ptr_dev_info_t->oob_size));
-			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: _current_cache_page_oob_mapping:\n");
-			_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page_oob_mapping[0], (ptr_dev_info_t->oob_size));
 		}
 noecc:
 		_current_page_num = page_number;
@@ -3183,7 +3421,99 @@ noecc:
 	return rtn_status;
 }
 
-static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number,
+/* Read the data area of a whole page straight into the caller buffer */
+static SPI_NAND_FLASH_RTN_T spi_nand_read_page_direct (u32 page_number, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode, u8 *ptr_rtn_buf)
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	/* The software cache already holds this page */
+	if( _current_page_num == page_number )
+	{
+		memcpy( ptr_rtn_buf, &_current_cache_page_data[0], ptr_dev_info_t->page_size );
+		return rtn_status;
+	}
+
+	_SPI_NAND_ENABLE_MANUAL_MODE();
+
+	if( spi_nand_load_page_into_cache(page_number) == SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK )
+	{
+		_SPI_NAND_PRINTF("spi_nand_read_page_direct: Bad Block, ECC cannot recovery detecte, page = 0x%x\n", page_number);
+		rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
+	}
+
+	if( ((ptr_dev_info_t->feature) & SPI_NAND_FLASH_PLANE_SELECT_HAVE) )
+	{
+		_plane_select_bit = ((page_number >> 6)& (0x1));
+	}
+
+	spi_nand_protocol_read_from_cache(0, ptr_dev_info_t->page_size, ptr_rtn_buf, speed_mode, ptr_dev_info_t->dummy_mode );
+
+	return rtn_status;
+}
+
+/* Read len bytes at column of a page, loading the page into the chip cache only if needed */
+static SPI_NAND_FLASH_RTN_T spi_nand_read_page_column (u32 page_number, u32 column, u32 len, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode, u8 *ptr_rtn_buf)
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	if( _current_page_num == page_number )
+	{
+		memcpy( ptr_rtn_buf, &_current_cache_page_data[column], len );
+		return rtn_status;
+	}
+
+	_SPI_NAND_ENABLE_MANUAL_MODE();
+
+	if( spi_nand_load_page_into_cache(page_number) == SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK )
+	{
+		_SPI_NAND_PRINTF("spi_nand_read_page_column: Bad Block, ECC cannot recovery detecte, page = 0x%x\n", page_number);
+		rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
+	}
+
+	if( ((ptr_dev_info_t->feature) & SPI_NAND_FLASH_PLANE_SELECT_HAVE) )
+	{
+		_plane_select_bit = ((page_number >> 6)& (0x1));
+	}
+
+	spi_nand_protocol_read_from_cache(column, len, ptr_rtn_buf, speed_mode, ptr_dev_info_t->dummy_mode );
+
+	return rtn_status;
+}
+
+/* Some manufacturers want WRITE ENABLE between PROGRAM LOAD and PROGRAM EXECUTE */
+static bool spi_nand_write_enable_after_load( const struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t )
+{
+	bool weafter = false;
+
+	switch(ptr_dev_info_t->mfr_id){
+		case _SPI_NAND_MANUFACTURER_ID_FORESEE:
+		switch(ptr_dev_info_t->dev_id){
+		case _SPI_NAND_DEVICE_ID_FS35ND02GS3Y2:
+			break;
+		default:
+			weafter = true;
+		}
+	}
+
+	return (weafter ||
+		((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_GIGADEVICE) ||
+		((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_PN) ||
+		((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_FM) ||
+		((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_XTX) ||
+		((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_FISON) ||
+		((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_TYM) ||
+		((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_ATO_2) ||
+		(((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_ATO) && ((ptr_dev_info_t->dev_id) == _SPI_NAND_DEVICE_ID_ATO25D2GA)));
+}
+
+/* Load the page into the chip and start PROGRAM EXECUTE, without waiting for it */
+static SPI_NAND_FLASH_RTN_T spi_nand_write_page_start(u32 page_number,
 		u32 data_offset,
 		u8  *ptr_data,
 		u32 data_len,
@@ -3192,10 +3522,8 @@ static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number,
 		u32 oob_len,
 		SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_mode)
 {
-		u8 status, status_2;
-		u32 i = 0, j = 0, idx = 0;
+		u32 i = 0, j = 0;
 		struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
-		struct spi_nand_flash_oobfree *ptr_oob_entry_idx;
 		SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 		u16 write_addr;
 
@@ -3223,15 +3551,14 @@ static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number,
 			{
 				if(_ondie_ecc_flag == 1)	/*  When OnDie ecc is enable,  mapping oob area is neccessary */
 				{
-					ptr_oob_entry_idx = (struct spi_nand_flash_oobfree*) &( ptr_dev_info_t->oob_free_layout->oobfree );
-							
-					for( i = 0; (i < SPI_NAND_FLASH_OOB_FREE_ENTRY_MAX) && (ptr_oob_entry_idx[i].len) && ((idx < (ptr_dev_info_t->oob_free_layout->oobsize)) && (idx < oob_len))  ; i++)
+					for( i = 0; (i < _oob_run_count) && (_oob_runs[i].logical < oob_len); i++)
 					{
-						for(j = 0; (j < (ptr_oob_entry_idx[i].len)) && (idx < (ptr_dev_info_t->oob_free_layout->oobsize)) && ((idx < (ptr_dev_info_t->oob_free_layout->oobsize)) && (idx < oob_len)) ; j++)
-						{
-							_current_cache_page_oob[(ptr_oob_entry_idx[i].offset)+j] &= ptr_oob[idx];
-							idx++;
-						}
+						u8 *ptr_phys = &_current_cache_page_oob[_oob_runs[i].phys];
+						const u8 *ptr_logical = &ptr_oob[_oob_runs[i].logical];
+						u32 run_len = min((u32)_oob_runs[i].len, oob_len - _oob_runs[i].logical);
+
+						for( j = 0; j < run_len; j++ )
+							ptr_phys[j] &= ptr_logical[j];
 					}
 				}
 				else
@@ -3255,27 +3582,8 @@ static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number,
 
 		spi_nand_select_die ( page_number );
 
-		bool weafter = false;
-		switch(ptr_dev_info_t->mfr_id){
-			case _SPI_NAND_MANUFACTURER_ID_FORESEE:
-			switch(ptr_dev_info_t->dev_id){
-			case _SPI_NAND_DEVICE_ID_FS35ND02GS3Y2:
-				break;
-			default:
-				weafter = true;
-			}
-		}
-
 		/* Different Manufacturer have different program flow and setting */
-		if(weafter ||
-			((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_GIGADEVICE) ||
-			((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_PN) ||
-			((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_FM) ||
-			((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_XTX) ||
-			((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_FISON) ||
-			((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_TYM) ||
-			((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_ATO_2) ||
-			(((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_ATO) && ((ptr_dev_info_t->dev_id) == _SPI_NAND_DEVICE_ID_ATO25D2GA)))
+		if( spi_nand_write_enable_after_load(ptr_dev_info_t) )
 		{
 			{
 				spi_nand_protocol_program_load(write_addr,
@@ -3298,46 +3606,337 @@ static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number,
 						speed_mode);
 		}
 
-		/* Execute program data into SPI NAND chip  */
-		spi_nand_protocol_program_execute ( page_number );
+		/* Execute program data into SPI NAND chip  */
+		spi_nand_nop_take( page_number );
+		spi_nand_protocol_program_execute ( page_number );
+
+		/* The chip cache no longer holds the page as read */
+		SPI_NAND_Flash_Clear_Read_Cache_Data();
+
+		return (rtn_status);
+}
+
+/* Check the result of a program started by spi_nand_write_page_start() (die already selected) */
+static SPI_NAND_FLASH_RTN_T spi_nand_write_page_check(u32 page_number, u32 data_offset, u8 status)
+{
+		u8 status_2;
+
+		spi_nand_protocol_get_status_reg_1( &status_2);
+
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "[spi_nand_write_page]: status 1 = 0x%x, status 3 = 0x%x\n", status_2, status);
+
+		/* Check Program Fail Bit */
+		if( status & _SPI_NAND_VAL_PROGRAM_FAIL )
+		{
+			_SPI_NAND_PRINTF("spi_nand_write_page : Program Fail at addr_offset = 0x%x, page_number = 0x%x, status = 0x%x\n", data_offset, page_number, status);
+			return SPI_NAND_FLASH_RTN_PROGRAM_FAIL;
+		}
+
+		return SPI_NAND_FLASH_RTN_NO_ERROR;
+}
+
+static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number,
+		u32 data_offset,
+		u8  *ptr_data,
+		u32 data_len,
+		u32 oob_offset,
+		u8  *ptr_oob,
+		u32 oob_len,
+		SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_mode)
+{
+		u8 status;
+
+		spi_nand_write_page_start(page_number, data_offset, ptr_data, data_len,
+				oob_offset, ptr_oob, oob_len, speed_mode);
+
+		/* Checking status for erase complete */
+		do {
+			spi_nand_protocol_get_status_reg_3( &status);
+		} while( status & _SPI_NAND_VAL_OIP) ;
+
+		/*. Disable write_flash */
+		spi_nand_protocol_write_disable();
+
+		return spi_nand_write_page_check(page_number, data_offset, status);
+}
+
+/* Copy-back: PAGE READ the source into the chip cache and PROGRAM EXECUTE it to the destination */
+static SPI_NAND_FLASH_RTN_T spi_nand_copy_page( u32 src_page, u32 dst_page )
+{
+	u8 status;
+
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_copy_page: src = 0x%x, dst = 0x%x\n", src_page, dst_page);
+
+	_SPI_NAND_ENABLE_MANUAL_MODE();
+
+	/* The data only ever lands in the cache register, never in the software cache */
+	_chip_cache_page_num = 0xFFFFFFFF;
+
+	spi_nand_select_die ( src_page );
+
+	spi_nand_protocol_page_read ( src_page );
+
+	do {
+		spi_nand_protocol_get_status_reg_3( &status);
+	} while( status & _SPI_NAND_VAL_OIP) ;
+
+	/* With on-die ECC the cache holds corrected data, which is re-encoded on program */
+	if( ECC_fcheck && !ECC_ignore && (ecc_fail_check(src_page) == SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK) )
+		return (SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK);
+
+	spi_nand_protocol_write_enable();
+
+	spi_nand_nop_take( dst_page );
+	spi_nand_protocol_program_execute ( dst_page );
+
+	do {
+		spi_nand_protocol_get_status_reg_3( &status);
+	} while( status & _SPI_NAND_VAL_OIP) ;
+
+	spi_nand_protocol_write_disable();
+
+	return spi_nand_write_page_check(dst_page, 0, status);
+}
+
+int test_write_fail_flag = 0;
+
+/*
+ * Partial page program: only the columns written with something other than
+ * 0xFF are loaded. The first run uses PROGRAM LOAD, which resets the rest of
+ * the cache to 1s, and further runs use RANDOM PROGRAM LOAD.
+ * Only used with on-die ECC off: a later run into a sector that already
+ * holds data and parity would leave that parity wrong.
+ */
+static SPI_NAND_FLASH_RTN_T spi_nand_write_page_partial( u32 page_number, u32 data_offset, u8 *ptr_data, u32 data_len, SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_mode )
+{
+	u8 status;
+	u32 pos, start, end, gap, run;
+	bool loaded = false;
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	if( !spi_nand_nop_take(page_number) )
+	{
+		_SPI_NAND_PRINTF("spi_nand_write_page_partial : page 0x%x reached the NOP limit of %u, erase the block first\n", page_number, ptr_dev_info_t->nop ? ptr_dev_info_t->nop : 1);
+		return SPI_NAND_FLASH_RTN_PROGRAM_FAIL;
+	}
+
+	_SPI_NAND_ENABLE_MANUAL_MODE();
+
+	if( ((ptr_dev_info_t->feature) & SPI_NAND_FLASH_PLANE_SELECT_HAVE) )
+	{
+		_plane_select_bit = ((page_number >> 6) & (0x1));
+	}
+
+	spi_nand_select_die ( page_number );
+
+	if( !spi_nand_write_enable_after_load(ptr_dev_info_t) )
+		spi_nand_protocol_write_enable();
+
+	_chip_cache_page_num = 0xFFFFFFFF;
+
+	for( pos = 0; pos < data_len; pos = end )
+	{
+		/* Find the next run of bytes to program, short gaps of 0xFF cost less to send than a new command */
+		for( start = pos; (start < data_len) && (ptr_data[start] == 0xff); start++ );
+		if( start == data_len )
+			break;
+		for( end = start + 1, gap = 0; (end < data_len) && (gap <= _SPI_NAND_PARTIAL_GAP); end++ )
+			gap = (ptr_data[end] == 0xff) ? gap + 1 : 0;
+		end -= gap;
+
+		for( ; start < end; start += run )
+		{
+			run = min(end - start, 128);
+			_spi_nand_protocol_program_load(data_offset + start, &ptr_data[start], run, speed_mode, loaded);
+			loaded = true;
+		}
+	}
+
+	if( spi_nand_write_enable_after_load(ptr_dev_info_t) )
+		spi_nand_protocol_write_enable();
+
+	spi_nand_protocol_program_execute ( page_number );
+
+	do {
+		spi_nand_protocol_get_status_reg_3( &status);
+	} while( status & _SPI_NAND_VAL_OIP) ;
+
+	spi_nand_protocol_write_disable();
+
+	SPI_NAND_Flash_Clear_Read_Cache_Data();
+
+	return spi_nand_write_page_check(page_number, data_offset, status);
+}
+
+/* Program the same page of an even block and of the next block with one PROGRAM EXECUTE */
+static SPI_NAND_FLASH_RTN_T spi_nand_write_page_pair( u32 page_number, u8 *ptr_data_0, u8 *ptr_data_1, SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_mode )
+{
+	u8 status;
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	_SPI_NAND_ENABLE_MANUAL_MODE();
+
+	spi_nand_select_die ( page_number );
+
+	spi_nand_protocol_write_enable();
+
+	/* Plane 0: PROGRAM LOAD resets the cache to 1s, the spare area stays erased */
+	memcpy( &_current_cache_page[0], ptr_data_0, ptr_dev_info_t->page_size );
+	memset( &_current_cache_page[ptr_dev_info_t->page_size], 0xff, ptr_dev_info_t->oob_size );
+	_plane_select_bit = 0;
+	spi_nand_protocol_program_load(0, &_current_cache_page[0], ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)), speed_mode);
+
+	/* Plane 1: RANDOM PROGRAM LOAD keeps what is loaded for plane 0 */
+	memcpy( &_current_cache_page[0], ptr_data_1, ptr_dev_info_t->page_size );
+	_plane_select_bit = 1;
+	spi_nand_protocol_program_load_random(&_current_cache_page[0], ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)), speed_mode);
+
+	/* Both planes are programmed by one PROGRAM EXECUTE */
+	spi_nand_nop_take( page_number );
+	spi_nand_nop_take( page_number + (1 << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET) );
+	spi_nand_protocol_program_execute ( page_number + (1 << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET) );
+
+	do {
+		spi_nand_protocol_get_status_reg_3( &status);
+	} while( status & _SPI_NAND_VAL_OIP) ;
+
+	spi_nand_protocol_write_disable();
+
+	SPI_NAND_Flash_Clear_Read_Cache_Data();
+
+	return spi_nand_write_page_check(page_number, 0, status);
+}
+
+/* Two-plane program applies to a whole even block followed by its odd neighbour */
+static bool spi_nand_two_plane_ok( u64 write_addr, u64 remain_len )
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	u32 block_0, block_1;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	if( !snand_two_plane || !((ptr_dev_info_t->feature) & SPI_NAND_FLASH_MULTI_PLANE_PROGRAM_HAVE) )
+		return false;
+
+	if( (write_addr % (2 * ptr_dev_info_t->erase_size)) || (remain_len < (2 * ptr_dev_info_t->erase_size)) )
+		return false;
+
+	block_0 = spi_nand_bmt_map_addr(write_addr) / ptr_dev_info_t->erase_size;
+	block_1 = spi_nand_bmt_map_addr(write_addr + ptr_dev_info_t->erase_size) / ptr_dev_info_t->erase_size;
+
+	return ((block_0 & 0x1) == 0) && (block_1 == block_0 + 1);
+}
+
+static SPI_NAND_FLASH_RTN_T spi_nand_write_block_pair( u32 page_number, u8 *ptr_buf, SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_mode )
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	u32 i;
+	u8 *ptr_data_0, *ptr_data_1;
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	for( i = 0; i < (1 << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET); i++ )
+	{
+		ptr_data_0 = &ptr_buf[i * ptr_dev_info_t->page_size];
+		ptr_data_1 = &ptr_buf[ptr_dev_info_t->erase_size + i * ptr_dev_info_t->page_size];
+
+		if( mem_is_blank(ptr_data_0, ptr_dev_info_t->page_size) &&
+			mem_is_blank(ptr_data_1, ptr_dev_info_t->page_size) )
+			continue;
+
+		if( spi_nand_write_page_pair(page_number + i, ptr_data_0, ptr_data_1, speed_mode) != SPI_NAND_FLASH_RTN_NO_ERROR )
+			rtn_status = SPI_NAND_FLASH_RTN_PROGRAM_FAIL;
+	}
+
+	return rtn_status;
+}
+
+static SPI_NAND_FLASH_RTN_T spi_nand_write_interleaved( u64 dst_addr, u64 len, u64 *ptr_rtn_len, u8 *ptr_buf, SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_mode )
+{
+	struct spi_nand_die_job jobs[_SPI_NAND_MAX_DIE];
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	u32 die, die_num;
+	u64 written = 0, reported = 0;
+	u32 page_size, addr_offset, data_len;
+	u8 status;
+	bool pending = true;
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+	page_size = ptr_dev_info_t->page_size;
+	die_num = spi_nand_die_jobs_init( jobs, dst_addr, dst_addr + len, ((u64)1 << spi_nand_die_page_shift()) * page_size );
+
+	while( pending )
+	{
+		pending = false;
+
+		for( die = 0; die < die_num; die++ )
+		{
+			struct spi_nand_die_job *job = &jobs[die];
+
+			if( job->busy )
+			{
+				if( !spi_nand_die_job_poll(job, &status) )
+				{
+					pending = true;
+					continue;
+				}
 
-		/* Checking status for erase complete */
-		do {
-			spi_nand_protocol_get_status_reg_3( &status);
-		} while( status & _SPI_NAND_VAL_OIP) ;
+				if( spi_nand_write_page_check(job->busy_page, job->busy_offset, status) != SPI_NAND_FLASH_RTN_NO_ERROR )
+					rtn_status = SPI_NAND_FLASH_RTN_PROGRAM_FAIL;
+				else
+					*ptr_rtn_len += job->busy_len;
+				written += job->busy_len;
+			}
 
-		/*. Disable write_flash */
-		spi_nand_protocol_write_disable();
+			/* Start the next non blank page of this die */
+			while( job->next < job->end )
+			{
+				addr_offset = job->next % page_size;
+				data_len = min(page_size - addr_offset, job->end - job->next);
 
-		spi_nand_protocol_get_status_reg_1( &status_2);
+				if( mem_is_blank(&ptr_buf[job->next - dst_addr], data_len) )
+				{
+					job->next += data_len;
+					written += data_len;
+					*ptr_rtn_len += data_len;
+					continue;
+				}
 
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "[spi_nand_write_page]: status 1 = 0x%x, status 3 = 0x%x\n", status_2, status);
-#if 0
-		print_dot++;
-		if( (print_dot % 20) == 0 )
-		{
-			_SPI_NAND_PRINTF(".");
+				job->busy_page = job->next / page_size;
+				job->busy_offset = addr_offset;
+				job->busy_len = data_len;
+				spi_nand_write_page_start(job->busy_page, addr_offset, &ptr_buf[job->next - dst_addr],
+						data_len, 0, NULL, 0, speed_mode);
+				job->next += data_len;
+				job->busy = true;
+				pending = true;
+				break;
+			}
+
+			if( written == reported )
+				continue;
+			reported = written;
+			printf("\bWritten %d%% [%llu] of [%llu] bytes      ", (int)(100 * (written / 1024) / (len / 1024)), written, len);
+			printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 			fflush(stdout);
 		}
-#endif
-		/* Check Program Fail Bit */
-		if( status & _SPI_NAND_VAL_PROGRAM_FAIL )
-		{
-			_SPI_NAND_PRINTF("spi_nand_write_page : Program Fail at addr_offset = 0x%x, page_number = 0x%x, status = 0x%x\n", data_offset, page_number, status);
-			rtn_status = SPI_NAND_FLASH_RTN_PROGRAM_FAIL;
-		}
-
-		SPI_NAND_Flash_Clear_Read_Cache_Data();
+	}
+	printf("Written 100%% [%llu] of [%llu] bytes      \n", written, len);
 
-		return (rtn_status);
+	return (rtn_status);
 }
 
-int test_write_fail_flag = 0;
 
 /*------------------------------------------------------------------------------------
- * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_write_internal( u32    dst_addr,
- *                                                                u32    len,
- *                                                                u32    *ptr_rtn_len,
+ * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_write_internal( u64    dst_addr,
+ *                                                                u64    len,
+ *                                                                u64    *ptr_rtn_len,
  *                                                                u8*    ptr_buf      )
  * PURPOSE : To write flash internally.
  * AUTHOR  :
@@ -3356,10 +3955,10 @@ int test_write_fail_flag = 0;
  *
  *------------------------------------------------------------------------------------
  */
-static SPI_NAND_FLASH_RTN_T spi_nand_write_internal( u32 dst_addr, u32 len, u32 *ptr_rtn_len, u8* ptr_buf, SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_mode )
+static SPI_NAND_FLASH_RTN_T spi_nand_write_internal( u64 dst_addr, u64 len, u64 *ptr_rtn_len, u8* ptr_buf, SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_mode )
 {
-	u32 remain_len, write_addr, data_len, page_number, physical_dst_addr;
-	u32 addr_offset;
+	u64 remain_len, write_addr, physical_dst_addr;
+	u32 data_len, page_number, addr_offset;
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 #if 0
@@ -3375,18 +3974,39 @@ static SPI_NAND_FLASH_RTN_T spi_nand_write_internal( u32 dst_addr, u32 len, u32
 
 	SPI_NAND_Flash_Clear_Read_Cache_Data();
 
-	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_write_internal: remain_len = 0x%x\n", remain_len);
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_write_internal: remain_len = 0x%llx\n", remain_len);
+
+	/* Stacked dies program in parallel */
+	if( spi_nand_range_spans_dies(dst_addr, len) )
+	{
+		rtn_status = spi_nand_write_interleaved( dst_addr, len, ptr_rtn_len, ptr_buf, speed_mode );
+		_SPI_NAND_SEMAPHORE_UNLOCK();
+		return (rtn_status);
+	}
 
 	while( remain_len > 0 )
 	{
-		physical_dst_addr = write_addr;
+		physical_dst_addr = spi_nand_bmt_map_addr(write_addr);
 
 		/* Caculate page number */
 		addr_offset = (physical_dst_addr % (ptr_dev_info_t->page_size));
 		page_number = (physical_dst_addr / (ptr_dev_info_t->page_size));
 
 		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1,
-				"\nspi_nand_write_internal: addr_offset = 0x%x, page_number = 0x%x, remain_len = 0x%x, page_size = 0x%x\n", addr_offset, page_number, remain_len,(ptr_dev_info_t->page_size) );
+				"\nspi_nand_write_internal: addr_offset = 0x%x, page_number = 0x%x, remain_len = 0x%llx, page_size = 0x%x\n", addr_offset, page_number, remain_len,(ptr_dev_info_t->page_size) );
+
+		/* Two blocks on different planes are programmed together */
+		if( spi_nand_two_plane_ok(write_addr, remain_len) )
+		{
+			data_len = 2 * ptr_dev_info_t->erase_size;
+			if( spi_nand_write_block_pair(page_number, &(ptr_buf[len - remain_len]), speed_mode) != SPI_NAND_FLASH_RTN_NO_ERROR )
+			{
+				rtn_status = SPI_NAND_FLASH_RTN_PROGRAM_FAIL;
+				break;
+			}
+			goto next;
+		}
+
 		if( ((addr_offset + remain_len ) > (ptr_dev_info_t->page_size))  )  /* data cross over than 1 page range */
 		{
 			data_len = ((ptr_dev_info_t->page_size) - addr_offset);
@@ -3400,33 +4020,42 @@ static SPI_NAND_FLASH_RTN_T spi_nand_write_internal( u32 dst_addr, u32 len, u32
 		 * Check if the target page is all ones and skip it if that's
 		 * the case
 		 */
-		//printf("data len %d\n", data_len);
-		for(int i = 0; i < data_len; i++) {
-			if(ptr_buf[(len - remain_len) + i] != 0xff)
-				goto write;
+		if( mem_is_blank(&ptr_buf[len - remain_len], data_len) )
+			goto next;
+
+		if( snand_partial_program && (_ondie_ecc_flag == 0) )
+		{
+			rtn_status = spi_nand_write_page_partial(page_number, addr_offset,
+					&(ptr_buf[len - remain_len]), data_len, speed_mode);
+		}
+		else
+		{
+			rtn_status = spi_nand_write_page(page_number, addr_offset,
+					&(ptr_buf[len - remain_len]), data_len, 0, NULL, 0 , speed_mode);
 		}
-		goto skip;
-write:
-		rtn_status = spi_nand_write_page(page_number, addr_offset,
-				&(ptr_buf[len - remain_len]), data_len, 0, NULL, 0 , speed_mode);
-skip:
+
+		/* Stop at the first failure, a later page must not report success */
+		if( rtn_status != SPI_NAND_FLASH_RTN_NO_ERROR )
+			break;
+
+next:
 		/* 8. Write remain data if neccessary */
 		write_addr += data_len;
 		remain_len -= data_len;
-		ptr_rtn_len += data_len;
-		printf("\bWritten %d%% [%u] of [%u] bytes      ", 100 * ((len - remain_len) / 1024) / (len / 1024), len - remain_len, len);
+		*ptr_rtn_len += data_len;
+		printf("\bWritten %d%% [%llu] of [%llu] bytes      ", (int)(100 * ((len - remain_len) / 1024) / (len / 1024)), len - remain_len, len);
 		printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 		fflush(stdout);
 	}
-	printf("Written 100%% [%u] of [%u] bytes      \n", len - remain_len, len);
+	printf("Written 100%% [%llu] of [%llu] bytes      \n", len - remain_len, len);
 	_SPI_NAND_SEMAPHORE_UNLOCK();
 
 	return (rtn_status);
 }
 
 /*------------------------------------------------------------------------------------
- * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_read_internal( u32     addr,
- *                                                               u32     len,
+ * FUNCTION: static SPI_NAND_FLASH_RTN_T spi_nand_read_internal( u64     addr,
+ *                                                               u64     len,
  *                                                               u8      *ptr_rtn_buf )
  * PURPOSE : To read flash internally.
  * AUTHOR  :
@@ -3444,11 +4073,11 @@ skip:
  *
  *------------------------------------------------------------------------------------
  */
-static SPI_NAND_FLASH_RTN_T spi_nand_read_internal ( u32 addr, u32 len, u8 *ptr_rtn_buf, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode,
+static SPI_NAND_FLASH_RTN_T spi_nand_read_internal ( u64 addr, u64 len, u8 *ptr_rtn_buf, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode,
 									SPI_NAND_FLASH_RTN_T *status)
 {
-	u32 page_number, data_offset;
-	u32 read_addr, physical_read_addr, remain_len;
+	u32 page_number, data_offset, data_len;
+	u64 read_addr, physical_read_addr, remain_len;
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 
@@ -3459,45 +4088,58 @@ static SPI_NAND_FLASH_RTN_T spi_nand_read_internal ( u32 addr, u32 len, u8 *ptr_
 	read_addr = addr;
 	remain_len = len;
 
-	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "\nspi_nand_read_internal : addr = 0x%lx, len = 0x%x\n", addr, len );
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "\nspi_nand_read_internal : addr = 0x%llx, len = 0x%llx\n", addr, len );
 
 	_SPI_NAND_SEMAPHORE_LOCK();
 
 	*status = SPI_NAND_FLASH_RTN_NO_ERROR;
+	_ecc_corrected_pages = 0;
+	_ecc_max_bitflips = 0;
 
 	while(remain_len > 0)
 	{
-		physical_read_addr = read_addr;
+		physical_read_addr = spi_nand_bmt_map_addr(read_addr);
 
 		/* Caculate page number */
 		data_offset = (physical_read_addr % (ptr_dev_info_t->page_size));
 		page_number = (physical_read_addr / (ptr_dev_info_t->page_size));
 
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_read_internal: read_addr = 0x%x, page_number = 0x%x, data_offset = 0x%x\n", physical_read_addr, page_number, data_offset);
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_read_internal: read_addr = 0x%llx, page_number = 0x%x, data_offset = 0x%x\n", physical_read_addr, page_number, data_offset);
+
+		/* Whole pages go from the chip cache straight to the caller */
+		if( (data_offset == 0) && (remain_len >= ptr_dev_info_t->page_size) )
+		{
+			rtn_status = spi_nand_read_page_direct(page_number, speed_mode, &ptr_rtn_buf[len - remain_len]);
+			if(rtn_status == SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK) {
+				*status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
+				_SPI_NAND_SEMAPHORE_UNLOCK();
+				return (rtn_status);
+			}
+			remain_len -= ptr_dev_info_t->page_size;
+			read_addr += ptr_dev_info_t->page_size;
+			goto progress;
+		}
 
-		rtn_status = spi_nand_read_page(page_number, speed_mode);
+		/* Partial pages only pull the requested columns out of the chip cache */
+		data_len = min(remain_len, ptr_dev_info_t->page_size - data_offset);
+		rtn_status = spi_nand_read_page_column(page_number, data_offset, data_len, speed_mode, &ptr_rtn_buf[len - remain_len]);
 		if(rtn_status == SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK) {
 			*status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
+			_SPI_NAND_SEMAPHORE_UNLOCK();
 			return (rtn_status);
 		}
-
-		/* 3. Retrieve the request data */
-		if( (data_offset + remain_len) < ptr_dev_info_t->page_size )
-		{
-			memcpy( &ptr_rtn_buf[len - remain_len], &_current_cache_page_data[data_offset], (sizeof(unsigned char)*remain_len) );
-			remain_len = 0;
-		}
-		else
-		{
-			memcpy( &ptr_rtn_buf[len - remain_len], &_current_cache_page_data[data_offset], (sizeof(unsigned char)*(ptr_dev_info_t->page_size - data_offset)));
-			remain_len -= (ptr_dev_info_t->page_size - data_offset);
-			read_addr += (ptr_dev_info_t->page_size - data_offset);
-		}
-		printf("\bRead %d%% [%u] of [%u] bytes      ", 100 * ((len - remain_len) / 1024) / (len / 1024), len - remain_len, len);
+		remain_len -= data_len;
+		read_addr += data_len;
+progress:
+		if( snand_read_progress )
+			snand_read_progress(len - remain_len);
+		printf("\bRead %d%% [%llu] of [%llu] bytes      ", (int)(100 * ((len - remain_len) / 1024) / (len / 1024)), len - remain_len, len);
 		printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 		fflush(stdout);
 	}
-	printf("Read 100%% [%u] of [%u] bytes      \n", len - remain_len, len);
+	printf("Read 100%% [%llu] of [%llu] bytes      \n", len - remain_len, len);
+	if( _ecc_corrected_pages )
+		_SPI_NAND_PRINTF("ECC corrected bitflips in %u pages, up to %u bitflips per page\n", _ecc_corrected_pages, _ecc_max_bitflips);
 	_SPI_NAND_SEMAPHORE_UNLOCK();
 
 	return (rtn_status);
@@ -3911,113 +4553,109 @@ static void spi_nand_manufacute_init( struct SPI_NAND_FLASH_INFO_T *ptr_device_t
  *
  *------------------------------------------------------------------------------------
  */
+#define _SPI_NAND_ID_HASH_SIZE		256	/* power of two, above twice the table size */
+
+/* Index + 1 of the first table entry for each (mfr_id, dev_id), 0 if empty */
+static u8 spi_nand_id_hash[_SPI_NAND_ID_HASH_SIZE];
+static bool spi_nand_id_hashed = false;
+
+static u32 spi_nand_id_hash_slot( u8 mfr_id, u8 dev_id )
+{
+	return ((((u32)mfr_id << 8) | dev_id) * 2654435761U) >> 24;
+}
+
+static const struct SPI_NAND_FLASH_INFO_T *spi_nand_lookup_id( u8 mfr_id, u8 dev_id )
+{
+	const struct SPI_NAND_FLASH_INFO_T *ptr_entry;
+	u32 i, slot;
+
+	if( !spi_nand_id_hashed )
+	{
+		for ( i = 0; i < (sizeof(spi_nand_flash_tables)/sizeof(struct SPI_NAND_FLASH_INFO_T)); i++)
+		{
+			ptr_entry = &spi_nand_flash_tables[i];
+			slot = spi_nand_id_hash_slot( ptr_entry->mfr_id, ptr_entry->dev_id );
+
+			/* same ID twice: the first entry wins, as with a linear scan */
+			while( spi_nand_id_hash[slot] && ((spi_nand_flash_tables[spi_nand_id_hash[slot] - 1].mfr_id != ptr_entry->mfr_id) ||
+						(spi_nand_flash_tables[spi_nand_id_hash[slot] - 1].dev_id != ptr_entry->dev_id)) )
+				slot = (slot + 1) & (_SPI_NAND_ID_HASH_SIZE - 1);
+
+			if( spi_nand_id_hash[slot] == 0 )
+				spi_nand_id_hash[slot] = i + 1;
+		}
+		spi_nand_id_hashed = true;
+	}
+
+	for( slot = spi_nand_id_hash_slot(mfr_id, dev_id); spi_nand_id_hash[slot]; slot = (slot + 1) & (_SPI_NAND_ID_HASH_SIZE - 1) )
+	{
+		ptr_entry = &spi_nand_flash_tables[spi_nand_id_hash[slot] - 1];
+
+		if( (ptr_entry->mfr_id == mfr_id) && (ptr_entry->dev_id == dev_id) )
+			return ptr_entry;
+	}
+
+	return NULL;
+}
+
+static void spi_nand_probe_fill( struct SPI_NAND_FLASH_INFO_T *ptr_rtn_device_t, const struct SPI_NAND_FLASH_INFO_T *ptr_table )
+{
+	ecc_size = ((ptr_table->device_size / ptr_table->erase_size) * ((ptr_table->erase_size / ptr_table->page_size) * ptr_table->oob_size));
+	ptr_rtn_device_t->device_size = ECC_fcheck ? ptr_table->device_size : ptr_table->device_size + ecc_size;
+	erase_oob_size                = (ptr_table->erase_size / ptr_table->page_size) * ptr_table->oob_size;
+	ptr_rtn_device_t->erase_size  = ECC_fcheck ? ptr_table->erase_size : ptr_table->erase_size + erase_oob_size;
+	ptr_rtn_device_t->page_size   = ECC_fcheck ? ptr_table->page_size : ptr_table->page_size + ptr_table->oob_size;
+	ptr_rtn_device_t->oob_size    = ECC_fcheck ? ptr_table->oob_size : 0;
+	bmt_oob_size                  = ptr_table->oob_size;
+	ptr_rtn_device_t->dummy_mode  = ptr_table->dummy_mode;
+	ptr_rtn_device_t->read_mode   = ptr_table->read_mode;
+	ptr_rtn_device_t->write_mode  = ptr_table->write_mode;
+	ptr_rtn_device_t->ptr_name    = ptr_table->ptr_name;
+	ptr_rtn_device_t->oob_free_layout = ptr_table->oob_free_layout;
+	ptr_rtn_device_t->ecc_status  = ptr_table->ecc_status;
+	ptr_rtn_device_t->feature     = ptr_table->feature;
+	ptr_rtn_device_t->nop         = ptr_table->nop;
+}
+
 static SPI_NAND_FLASH_RTN_T spi_nand_probe( struct SPI_NAND_FLASH_INFO_T *ptr_rtn_device_t )
 {
-	u32 i = 0;
+	const struct SPI_NAND_FLASH_INFO_T *ptr_table;
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_PROBE_ERROR;
 
 	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_probe: start \n");
 
-	/* Protocol for read id */
+	/* Protocol for read id, shared with the SPI NOR probe */
 	_SPI_NAND_SEMAPHORE_LOCK();
-	printf("here xx1\n");
-	spi_nand_protocol_read_id( ptr_rtn_device_t );
-	spi_nand_protocol_read_id( ptr_rtn_device_t );
-	printf("here xx2\n");
+	if( !flash_probe_id.valid )
+		flash_read_id( &flash_probe_id );
 	_SPI_NAND_SEMAPHORE_UNLOCK();
 
-	for ( i = 0; i < (sizeof(spi_nand_flash_tables)/sizeof(struct SPI_NAND_FLASH_INFO_T)); i++)
-	{
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1,"spi_nand_probe: table[%d]: mfr_id = 0x%x, dev_id = 0x%x\n", i, spi_nand_flash_tables[i].mfr_id, spi_nand_flash_tables[i].dev_id );
+	/* ID after an address or dummy byte (most chips, also Toshiba/KIOXIA) */
+	ptr_rtn_device_t->mfr_id = flash_probe_id.raw[1];
+	ptr_rtn_device_t->dev_id = flash_probe_id.raw[2];
+	ptr_table = spi_nand_lookup_id( ptr_rtn_device_t->mfr_id, ptr_rtn_device_t->dev_id );
 
-		if ( ( (ptr_rtn_device_t->mfr_id) == spi_nand_flash_tables[i].mfr_id) &&
-		     ( (ptr_rtn_device_t->dev_id) == spi_nand_flash_tables[i].dev_id)  )
-		{
-			ecc_size = ((spi_nand_flash_tables[i].device_size / spi_nand_flash_tables[i].erase_size) * ((spi_nand_flash_tables[i].erase_size / spi_nand_flash_tables[i].page_size) * spi_nand_flash_tables[i].oob_size));
-			ptr_rtn_device_t->device_size = ECC_fcheck ? spi_nand_flash_tables[i].device_size : spi_nand_flash_tables[i].device_size + ecc_size;
-			erase_oob_size                = (spi_nand_flash_tables[i].erase_size / spi_nand_flash_tables[i].page_size) * spi_nand_flash_tables[i].oob_size;
-			ptr_rtn_device_t->erase_size  = ECC_fcheck ? spi_nand_flash_tables[i].erase_size : spi_nand_flash_tables[i].erase_size + erase_oob_size;
-			ptr_rtn_device_t->page_size   = ECC_fcheck ? spi_nand_flash_tables[i].page_size : spi_nand_flash_tables[i].page_size + spi_nand_flash_tables[i].oob_size;
-			ptr_rtn_device_t->oob_size    = ECC_fcheck ? spi_nand_flash_tables[i].oob_size : 0;
-			bmt_oob_size                  = spi_nand_flash_tables[i].oob_size;
-			ptr_rtn_device_t->dummy_mode  = spi_nand_flash_tables[i].dummy_mode;
-			ptr_rtn_device_t->read_mode   = spi_nand_flash_tables[i].read_mode;
-			ptr_rtn_device_t->write_mode  = spi_nand_flash_tables[i].write_mode;
-			memcpy( &(ptr_rtn_device_t->ptr_name) , &(spi_nand_flash_tables[i].ptr_name), sizeof(ptr_rtn_device_t->ptr_name));
-			memcpy( &(ptr_rtn_device_t->oob_free_layout) , &(spi_nand_flash_tables[i].oob_free_layout), sizeof(ptr_rtn_device_t->oob_free_layout));
-			ptr_rtn_device_t->feature = spi_nand_flash_tables[i].feature;
-
-			rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-			break;
-		}
+	if( ptr_table == NULL )
+	{
+		/* ID right after the command (For example, the GigaDevice SPI NADN chip for Type C */
+		ptr_rtn_device_t->mfr_id = flash_probe_id.raw[0];
+		ptr_rtn_device_t->dev_id = flash_probe_id.raw[1];
+		ptr_table = spi_nand_lookup_id( ptr_rtn_device_t->mfr_id, ptr_rtn_device_t->dev_id );
 	}
 
-	if ( rtn_status != SPI_NAND_FLASH_RTN_NO_ERROR )
+	if( (ptr_table == NULL) && !snor_match_id(flash_probe_id.raw) )
 	{
-		/* Another protocol for read id  (For example, the GigaDevice SPI NADN chip for Type C */
+		/* Chips which need the 0x00 address byte to return the ID */
 		_SPI_NAND_SEMAPHORE_LOCK();
-		spi_nand_protocol_read_id_2( ptr_rtn_device_t );
+		spi_nand_protocol_read_id( ptr_rtn_device_t );
 		_SPI_NAND_SEMAPHORE_UNLOCK();
-
-		for ( i = 0; i < (sizeof(spi_nand_flash_tables) / sizeof(struct SPI_NAND_FLASH_INFO_T)); i++)
-		{
-			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1,"spi_nand_probe: table[%d]: mfr_id = 0x%x, dev_id = 0x%x\n", i, spi_nand_flash_tables[i].mfr_id, spi_nand_flash_tables[i].dev_id );
-
-			if ( ( (ptr_rtn_device_t->mfr_id) == spi_nand_flash_tables[i].mfr_id) &&
-			     ( (ptr_rtn_device_t->dev_id) == spi_nand_flash_tables[i].dev_id)  )
-			{
-				ecc_size = ((spi_nand_flash_tables[i].device_size / spi_nand_flash_tables[i].erase_size) * ((spi_nand_flash_tables[i].erase_size / spi_nand_flash_tables[i].page_size) * spi_nand_flash_tables[i].oob_size));
-				ptr_rtn_device_t->device_size = ECC_fcheck ? spi_nand_flash_tables[i].device_size : spi_nand_flash_tables[i].device_size + ecc_size;
-				erase_oob_size                = (spi_nand_flash_tables[i].erase_size / spi_nand_flash_tables[i].page_size) * spi_nand_flash_tables[i].oob_size;
-				ptr_rtn_device_t->erase_size  = ECC_fcheck ? spi_nand_flash_tables[i].erase_size : spi_nand_flash_tables[i].erase_size + erase_oob_size;
-				ptr_rtn_device_t->page_size   = ECC_fcheck ? spi_nand_flash_tables[i].page_size : spi_nand_flash_tables[i].page_size + spi_nand_flash_tables[i].oob_size;
-				ptr_rtn_device_t->oob_size    = ECC_fcheck ? spi_nand_flash_tables[i].oob_size : 0;
-				bmt_oob_size                  = spi_nand_flash_tables[i].oob_size;
-				ptr_rtn_device_t->dummy_mode  = spi_nand_flash_tables[i].dummy_mode;
-				ptr_rtn_device_t->read_mode   = spi_nand_flash_tables[i].read_mode;
-				ptr_rtn_device_t->write_mode  = spi_nand_flash_tables[i].write_mode;
-				memcpy( &(ptr_rtn_device_t->ptr_name) , &(spi_nand_flash_tables[i].ptr_name), sizeof(ptr_rtn_device_t->ptr_name));
-				memcpy( &(ptr_rtn_device_t->oob_free_layout) , &(spi_nand_flash_tables[i].oob_free_layout), sizeof(ptr_rtn_device_t->oob_free_layout));
-				ptr_rtn_device_t->feature = spi_nand_flash_tables[i].feature;
-
-				rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-				break;
-			}
-		}
+		ptr_table = spi_nand_lookup_id( ptr_rtn_device_t->mfr_id, ptr_rtn_device_t->dev_id );
 	}
 
-	if ( rtn_status != SPI_NAND_FLASH_RTN_NO_ERROR )
+	if( ptr_table != NULL )
 	{
-		/* Another protocol for read id  (For example, the Toshiba/KIOXIA SPI NAND chip */
-		_SPI_NAND_SEMAPHORE_LOCK();
-		spi_nand_protocol_read_id_3( ptr_rtn_device_t );
-		_SPI_NAND_SEMAPHORE_UNLOCK();
-
-		for ( i = 0; i < (sizeof(spi_nand_flash_tables) / sizeof(struct SPI_NAND_FLASH_INFO_T)); i++)
-		{
-			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1,"spi_nand_probe: table[%d]: mfr_id = 0x%x, dev_id = 0x%x\n", i, spi_nand_flash_tables[i].mfr_id, spi_nand_flash_tables[i].dev_id );
-
-			if ( ( (ptr_rtn_device_t->mfr_id) == spi_nand_flash_tables[i].mfr_id) &&
-			     ( (ptr_rtn_device_t->dev_id) == spi_nand_flash_tables[i].dev_id)  )
-			{
-				ecc_size = ((spi_nand_flash_tables[i].device_size / spi_nand_flash_tables[i].erase_size) * ((spi_nand_flash_tables[i].erase_size / spi_nand_flash_tables[i].page_size) * spi_nand_flash_tables[i].oob_size));
-				ptr_rtn_device_t->device_size = ECC_fcheck ? spi_nand_flash_tables[i].device_size : spi_nand_flash_tables[i].device_size + ecc_size;
-				erase_oob_size                = (spi_nand_flash_tables[i].erase_size / spi_nand_flash_tables[i].page_size) * spi_nand_flash_tables[i].oob_size;
-				ptr_rtn_device_t->erase_size  = ECC_fcheck ? spi_nand_flash_tables[i].erase_size : spi_nand_flash_tables[i].erase_size + erase_oob_size;
-				ptr_rtn_device_t->page_size   = ECC_fcheck ? spi_nand_flash_tables[i].page_size : spi_nand_flash_tables[i].page_size + spi_nand_flash_tables[i].oob_size;
-				ptr_rtn_device_t->oob_size    = ECC_fcheck ? spi_nand_flash_tables[i].oob_size : 0;
-				bmt_oob_size                  = spi_nand_flash_tables[i].oob_size;
-				ptr_rtn_device_t->dummy_mode  = spi_nand_flash_tables[i].dummy_mode;
-				ptr_rtn_device_t->read_mode   = spi_nand_flash_tables[i].read_mode;
-				ptr_rtn_device_t->write_mode  = spi_nand_flash_tables[i].write_mode;
-				memcpy( &(ptr_rtn_device_t->ptr_name) , &(spi_nand_flash_tables[i].ptr_name), sizeof(ptr_rtn_device_t->ptr_name));
-				memcpy( &(ptr_rtn_device_t->oob_free_layout) , &(spi_nand_flash_tables[i].oob_free_layout), sizeof(ptr_rtn_device_t->oob_free_layout));
-				ptr_rtn_device_t->feature = spi_nand_flash_tables[i].feature;
-
-				rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-				break;
-			}
-		}
+		spi_nand_probe_fill( ptr_rtn_device_t, ptr_table );
+		rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 	}
 
 	_SPI_NAND_PRINTF("spi_nand_probe: mfr_id = 0x%x, dev_id = 0x%x\n", ptr_rtn_device_t->mfr_id, ptr_rtn_device_t->dev_id);
@@ -4129,9 +4767,9 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Set_Flash_Info( struct SPI_NAND_FLASH_INFO_T
 }
 
 /*------------------------------------------------------------------------------------
- * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Write_Nbyte( u32    dst_addr,
- *                                                            u32    len,
- *                                                            u32    *ptr_rtn_len,
+ * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Write_Nbyte( u64    dst_addr,
+ *                                                            u64    len,
+ *                                                            u64    *ptr_rtn_len,
  *                                                            u8*    ptr_buf      )
  * PURPOSE : To provide interface for Write N Bytes into SPI NAND Flash.
  * AUTHOR  :
@@ -4150,7 +4788,7 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Set_Flash_Info( struct SPI_NAND_FLASH_INFO_T
  *
  *------------------------------------------------------------------------------------
  */
-SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Write_Nbyte( u32 dst_addr, u32 len, u32 *ptr_rtn_len, u8 *ptr_buf,
+SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Write_Nbyte( u64 dst_addr, u64 len, u64 *ptr_rtn_len, u8 *ptr_buf,
 						SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_node )
 {
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
@@ -4185,15 +4823,15 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Write_Nbyte( u32 dst_addr, u32 len, u32 *ptr
  *
  *------------------------------------------------------------------------------------
  */
-u32 SPI_NAND_Flash_Read_NByte(u32  addr, u32  len, u32  *retlen, u8 *buf, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode,
+u32 SPI_NAND_Flash_Read_NByte(u64  addr, u64  len, u64  *retlen, u8 *buf, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode,
 						SPI_NAND_FLASH_RTN_T *status)
 {
 	return spi_nand_read_internal(addr, len, buf, speed_mode, status);
 }
 
 /*------------------------------------------------------------------------------------
- * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Erase( u32  dst_addr,
- *                                                      u32  len      )
+ * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Erase( u64  dst_addr,
+ *                                                      u64  len      )
  * PURPOSE : To provide interface for Erase SPI NAND Flash.
  * AUTHOR  :
  * CALLED BY
@@ -4210,7 +4848,7 @@ u32 SPI_NAND_Flash_Read_NByte(u32  addr, u32  len, u32  *retlen, u8 *buf, SPI_NA
  *
  *------------------------------------------------------------------------------------
  */
-SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Erase( u32 dst_addr, u32 len )
+SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Erase( u64 dst_addr, u64 len )
 {
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 
@@ -4219,6 +4857,128 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Erase( u32 dst_addr, u32 len )
 	return (rtn_status);
 }
 
+/*------------------------------------------------------------------------------------
+ * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Relocate_Block( u32 src_block,
+ *                                                               u32 dst_block )
+ * PURPOSE : To move one block to another block inside SPI NAND Flash.
+ * AUTHOR  :
+ * CALLED BY
+ *   -
+ * CALLS
+ *   -
+ * PARAMs  :
+ *   INPUT : src_block - The src_block variable of this function.
+ *           dst_block - The dst_block variable of this function.
+ *   OUTPUT: None
+ * RETURN  : SPI_RTN_NO_ERROR - Successful.   Otherwise - Failed.
+ * NOTES   : The destination block is erased, then every page is copied with
+ *           internal copy-back, so no data crosses the SPI bus. Both blocks
+ *           must be on the same die, and on the same plane for chips with
+ *           SPI_NAND_FLASH_PLANE_SELECT_HAVE.
+ * MODIFICTION HISTORY:
+ *
+ *------------------------------------------------------------------------------------
+ */
+SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Relocate_Block( u32 src_block, u32 dst_block )
+{
+	u32 i, src_page, dst_page, block_num;
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	block_num = ptr_dev_info_t->device_size / ptr_dev_info_t->erase_size;
+	src_page = src_block << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET;
+	dst_page = dst_block << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET;
+
+	if( (src_block >= block_num) || (dst_block >= block_num) || (src_block == dst_block) )
+	{
+		_SPI_NAND_PRINTF("Relocate: invalid block pair 0x%x -> 0x%x\n", src_block, dst_block);
+		return (SPI_NAND_FLASH_RTN_ALIGNED_CHECK_FAIL);
+	}
+
+	/* Each die has its own cache register */
+	if( ((ptr_dev_info_t->feature) & (SPI_NAND_FLASH_DIE_SELECT_1_HAVE | SPI_NAND_FLASH_DIE_SELECT_2_HAVE)) &&
+		((src_page >> spi_nand_die_page_shift()) != (dst_page >> spi_nand_die_page_shift())) )
+	{
+		_SPI_NAND_PRINTF("Relocate: blocks 0x%x and 0x%x are on different dies\n", src_block, dst_block);
+		return (SPI_NAND_FLASH_RTN_ALIGNED_CHECK_FAIL);
+	}
+
+	/* Two-plane chips have one cache register per plane */
+	if( ((ptr_dev_info_t->feature) & SPI_NAND_FLASH_PLANE_SELECT_HAVE) && ((src_block ^ dst_block) & 0x1) )
+	{
+		_SPI_NAND_PRINTF("Relocate: blocks 0x%x and 0x%x are on different planes\n", src_block, dst_block);
+		return (SPI_NAND_FLASH_RTN_ALIGNED_CHECK_FAIL);
+	}
+
+	_SPI_NAND_SEMAPHORE_LOCK();
+
+	rtn_status = spi_nand_erase_block(dst_block);
+
+	for( i = 0; (rtn_status == SPI_NAND_FLASH_RTN_NO_ERROR) && (i < (1 << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET)); i++ )
+		rtn_status = spi_nand_copy_page(src_page + i, dst_page + i);
+
+	SPI_NAND_Flash_Clear_Read_Cache_Data();
+
+	_SPI_NAND_SEMAPHORE_UNLOCK();
+
+	return (rtn_status);
+}
+
+/*------------------------------------------------------------------------------------
+ * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Read_Random( u64 addr,
+ *                                                            u8  *ptr_rtn_buf,
+ *                                                            u32 len,
+ *                                                            SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode )
+ * PURPOSE : To read a few bytes at an arbitrary address from SPI NAND Flash.
+ * AUTHOR  :
+ * CALLED BY
+ *   -
+ * CALLS
+ *   -
+ * PARAMs  :
+ *   INPUT : addr       - The addr variable of this function.
+ *           len        - The len variable of this function.
+ *           speed_mode - The speed_mode variable of this function.
+ *   OUTPUT: ptr_rtn_buf - A pointer to the ptr_rtn_buf variable.
+ * RETURN  : SPI_RTN_NO_ERROR - Successful.   Otherwise - Failed.
+ * NOTES   : Each page is loaded with PAGE READ once and only the requested
+ *           columns are shifted out of the chip cache. No progress output.
+ * MODIFICTION HISTORY:
+ *
+ *------------------------------------------------------------------------------------
+ */
+SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Read_Random( u64 addr, u8 *ptr_rtn_buf, u32 len, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode )
+{
+	u32 page_number, data_offset, data_len;
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	_SPI_NAND_SEMAPHORE_LOCK();
+
+	while( len > 0 )
+	{
+		data_offset = (addr % (ptr_dev_info_t->page_size));
+		page_number = (spi_nand_bmt_map_addr(addr) / (ptr_dev_info_t->page_size));
+		data_len = min(len, ptr_dev_info_t->page_size - data_offset);
+
+		rtn_status = spi_nand_read_page_column(page_number, data_offset, data_len, speed_mode, ptr_rtn_buf);
+		if( rtn_status == SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK )
+			break;
+
+		ptr_rtn_buf += data_len;
+		addr += data_len;
+		len -= data_len;
+	}
+
+	_SPI_NAND_SEMAPHORE_UNLOCK();
+
+	return (rtn_status);
+}
+
 /*------------------------------------------------------------------------------------
  * FUNCTION: char SPI_NAND_Flash_Read_Byte( long     addr )
  * PURPOSE : To provide interface for read 1 Bytes from SPI NAND Flash.
@@ -4246,7 +5006,7 @@ unsigned char SPI_NAND_Flash_Read_Byte(unsigned long addr, SPI_NAND_FLASH_RTN_T
 
 	memset(buf,0x0,2);
 
-	spi_nand_read_internal(addr, len, &buf[0], ptr_dev_info_t->read_mode, status);
+	*status = SPI_NAND_Flash_Read_Random(addr, &buf[0], len, ptr_dev_info_t->read_mode);
 
 	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "SPI_NAND_Flash_Read_Byte : buf = 0x%x\n", buf[0]);
 
@@ -4280,7 +5040,7 @@ unsigned long SPI_NAND_Flash_Read_DWord(unsigned long addr, SPI_NAND_FLASH_RTN_T
 
 	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "SPI_NAND_Flash_Read_DWord, addr = 0x%llx\n", addr);
 
-	spi_nand_read_internal(addr, 4, &buf2[0], ptr_dev_info_t->read_mode, status);
+	*status = SPI_NAND_Flash_Read_Random(addr, &buf2[0], 4, ptr_dev_info_t->read_mode);
 	ret_val = (buf2[0] << 24) | (buf2[1] << 16) | (buf2[2] <<8) | buf2[3];
 
 	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "SPI_NAND_Flash_Read_DWord : ret_val = 0x%x\n", ret_val);
@@ -4309,6 +5069,13 @@ unsigned long SPI_NAND_Flash_Read_DWord(unsigned long addr, SPI_NAND_FLASH_RTN_T
 void SPI_NAND_Flash_Clear_Read_Cache_Data( void )
 {
 	_current_page_num = 0xFFFFFFFF;
+	_chip_cache_page_num = 0xFFFFFFFF;
+}
+
+/* Corrected bitflips reported by on-die ECC for the page loaded last */
+u32 SPI_NAND_Flash_Get_Page_Bitflips( void )
+{
+	return _current_page_bitflips;
 }
 
 SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Enable_OnDie_ECC( void )
@@ -4324,7 +5091,8 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Enable_OnDie_ECC( void )
 		die_num = (ptr_dev_info_t->device_size / ptr_dev_info_t->page_size) >> 16;
 
 		for(i = 0; i < die_num; i++) {
-			spi_nand_protocol_die_select_1(i);
+			_die_id = i;
+			spi_nand_protocol_die_select_1(_die_id);
 
 			spi_nand_protocol_get_status_reg_2(&feature);
 			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "before setting : SPI_NAND_Flash_Enable_OnDie_ECC, status reg = 0x%x\n", feature);
@@ -4342,7 +5110,8 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Enable_OnDie_ECC( void )
 		die_num = (ptr_dev_info_t->device_size / ptr_dev_info_t->page_size) >> 17;
 
 		for(i = 0; i < die_num; i++) {
-			spi_nand_protocol_die_select_2(i);
+			_die_id = i;
+			spi_nand_protocol_die_select_2(_die_id);
 
 			spi_nand_protocol_get_status_reg_2(&feature);
 			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "before setting : SPI_NAND_Flash_Enable_OnDie_ECC, status reg = 0x%x\n", feature);
@@ -4395,6 +5164,10 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Enable_OnDie_ECC( void )
 		_ondie_ecc_flag = 1;
 	else
 		_ondie_ecc_flag = 0;
+
+	spi_nand_compile_oob_layout();
+	_chip_cache_page_num = 0xFFFFFFFF;
+
 	return (SPI_NAND_FLASH_RTN_NO_ERROR);
 }
 
@@ -4410,14 +5183,14 @@ int nandflash_init(int rom_base)
 	}
 }
 
-int nandflash_read(unsigned long from, unsigned long len, unsigned long *retlen, unsigned char *buf, SPI_NAND_FLASH_RTN_T *status)
+int nandflash_read(unsigned long long from, unsigned long long len, unsigned long long *retlen, unsigned char *buf, SPI_NAND_FLASH_RTN_T *status)
 {
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
 
 	ptr_dev_info_t  = _SPI_NAND_GET_DEVICE_INFO_PTR;
 
 	timer_start();
-	if( SPI_NAND_Flash_Read_NByte(from, len, (u32 *)retlen, buf, ptr_dev_info_t->read_mode, status) == SPI_NAND_FLASH_RTN_NO_ERROR )
+	if( SPI_NAND_Flash_Read_NByte(from, len, retlen, buf, ptr_dev_info_t->read_mode, status) == SPI_NAND_FLASH_RTN_NO_ERROR )
 	{
 		timer_end();
 		return 0;
@@ -4428,7 +5201,7 @@ int nandflash_read(unsigned long from, unsigned long len, unsigned long *retlen,
 	}
 }
 
-int nandflash_erase(unsigned long offset, unsigned long len)
+int nandflash_erase(unsigned long long offset, unsigned long long len)
 {
 	timer_start();
 	if( SPI_NAND_Flash_Erase(offset, len) == SPI_NAND_FLASH_RTN_NO_ERROR )
@@ -4442,14 +5215,14 @@ int nandflash_erase(unsigned long offset, unsigned long len)
 	}
 }
 
-int nandflash_write(unsigned long to, unsigned long len, unsigned long *retlen, unsigned char *buf)
+int nandflash_write(unsigned long long to, unsigned long long len, unsigned long long *retlen, unsigned char *buf)
 {
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
 
 	ptr_dev_info_t  = _SPI_NAND_GET_DEVICE_INFO_PTR;
 
 	timer_start();
-	if( SPI_NAND_Flash_Write_Nbyte(to, len, (u32 *)retlen, buf,
+	if( SPI_NAND_Flash_Write_Nbyte(to, len, retlen, buf,
 			ptr_dev_info_t->write_mode) == SPI_NAND_FLASH_RTN_NO_ERROR )
 	{
 		timer_end();
@@ -4462,38 +5235,208 @@ int nandflash_write(unsigned long to, unsigned long len, unsigned long *retlen,
 }
 /* End of [spi_nand_flash.c] package */
 
-int snand_read(unsigned char *buf, unsigned long from, unsigned long len)
+long long snand_read(unsigned char *buf, unsigned long long from, unsigned long long len)
 {
-	unsigned long retlen = 0;
+	unsigned long long retlen = 0;
 	SPI_NAND_FLASH_RTN_T status;
 
-	if(!nandflash_read((unsigned long)from, (unsigned long)len, &retlen, buf, &status))
+	if(!nandflash_read(from, len, &retlen, buf, &status))
 		return len;
 	return -1;
 }
 
-int snand_erase(unsigned long offs, unsigned long len)
+int snand_erase(unsigned long long offs, unsigned long long len)
+{
+	return nandflash_erase(offs, len);
+}
+
+/* Move len bytes of whole blocks from offs to to without passing the data through the host */
+int snand_relocate(unsigned long long offs, unsigned long long to, unsigned long long len)
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+	u32 i, src_block, dst_block, count;
+
+	if ((offs % bsize) || (to % bsize) || (len % bsize)) {
+		printf("Relocate: addresses and length must be multiple of the block size 0x%08X\n", bsize);
+		return -1;
+	}
+	if (((offs < to) && (to < offs + len)) || ((to < offs) && (offs < to + len))) {
+		printf("Relocate: source and destination ranges overlap\n");
+		return -1;
+	}
+
+	src_block = offs / ptr_dev_info_t->erase_size;
+	dst_block = to / ptr_dev_info_t->erase_size;
+	count = len / ptr_dev_info_t->erase_size;
+
+	timer_start();
+	for (i = 0; i < count; i++) {
+		printf("Relocate block 0x%x -> 0x%x [%u] of [%u]\r", src_block + i, dst_block + i, i + 1, count);
+		fflush(stdout);
+		if (SPI_NAND_Flash_Relocate_Block(src_block + i, dst_block + i) != SPI_NAND_FLASH_RTN_NO_ERROR) {
+			printf("\nRelocate: failed at block 0x%x\n", src_block + i);
+			return -1;
+		}
+	}
+	printf("\n");
+	timer_end();
+
+	return 0;
+}
+
+#define _SPI_NAND_VAL_OTP_ENABLE			0x40	/* Feature B0h: OTP area access */
+#define _SPI_NAND_UID_SIZE				16
+
+/*
+ * With OTP access enabled, page 0 of Winbond, Micron, GigaDevice and MXIC
+ * parts is the unique ID page: 16 ID bytes followed by their complement.
+ * Returns the ID length, or -1 if the chip has no readable ID.
+ */
+int snand_read_uid(unsigned char *uid, int len)
 {
-	return nandflash_erase((unsigned long)offs, (unsigned long)len);
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+	u8 feature, status, buf[2 * _SPI_NAND_UID_SIZE];
+	int i;
+
+	if ((len < _SPI_NAND_UID_SIZE) ||
+		((ptr_dev_info_t->mfr_id != _SPI_NAND_MANUFACTURER_ID_WINBOND) &&
+		 (ptr_dev_info_t->mfr_id != _SPI_NAND_MANUFACTURER_ID_MICRON) &&
+		 (ptr_dev_info_t->mfr_id != _SPI_NAND_MANUFACTURER_ID_GIGADEVICE) &&
+		 (ptr_dev_info_t->mfr_id != _SPI_NAND_MANUFACTURER_ID_MXIC)))
+		return -1;
+
+	spi_nand_select_die( 0 );
+	spi_nand_protocol_get_status_reg_2( &feature );
+	spi_nand_protocol_set_status_reg_2( feature | _SPI_NAND_VAL_OTP_ENABLE );
+
+	spi_nand_protocol_page_read( 0 );
+	do {
+		spi_nand_protocol_get_status_reg_3( &status );
+	} while( status & _SPI_NAND_VAL_OIP );
+	spi_nand_protocol_read_from_cache( 0, sizeof(buf), buf, SPI_NAND_FLASH_READ_SPEED_MODE_SINGLE, ptr_dev_info_t->dummy_mode );
+
+	spi_nand_protocol_set_status_reg_2( feature );
+	_chip_cache_page_num = 0xFFFFFFFF;
+
+	for (i = 0; i < _SPI_NAND_UID_SIZE; i++)
+		if ((buf[i] ^ buf[_SPI_NAND_UID_SIZE + i]) != 0xFF)
+			return -1;
+
+	memcpy(uid, buf, _SPI_NAND_UID_SIZE);
+	return _SPI_NAND_UID_SIZE;
 }
 
-int snand_write(unsigned char *buf, unsigned long to, unsigned long len)
+long long snand_write(unsigned char *buf, unsigned long long to, unsigned long long len)
 {
-	unsigned long retlen = 0;
+	unsigned long long retlen = 0;
 
-	if(!nandflash_write((unsigned long)to, (unsigned long)len, &retlen, buf))
-		return (int)retlen;
+	if(!nandflash_write(to, len, &retlen, buf))
+		return (long long)retlen;
 	return -1;
 }
 
-long snand_init(void)
+long long snand_init(void)
 {
 	if(!nandflash_init(0)) {
 		struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
 		bsize = ptr_dev_info_t->erase_size;
-		return (long)(ptr_dev_info_t->device_size);
+		if (snand_two_plane && !((ptr_dev_info_t->feature) & SPI_NAND_FLASH_MULTI_PLANE_PROGRAM_HAVE))
+			printf("Two-plane program is not supported by this chip, using one plane.\n");
+		return (long long)(ptr_dev_info_t->device_size);
+	}
+	return -1;
+}
+
+/*
+ * Find the MediaTek BMT v1 in the last pool_percent of the blocks and switch
+ * snand_read/write/erase to logical addresses. Returns the logical size.
+ */
+long long snand_bmt_init(unsigned int pool_percent)
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+	u8 buf[_SPI_NAND_BMT_HEADER_SIZE + _SPI_NAND_BMT_MAX_SIZE * _SPI_NAND_BMT_ENTRY_SIZE];
+	u32 total, pool, system, block, mapped, bad, good, i;
+	u8 checksum, *entry;
+
+	if (!ECC_fcheck) {
+		printf("BMT: the table is only readable with on-die ECC enabled\n");
+		return -1;
+	}
+
+	free(_bmt_map);
+	_bmt_map = NULL;
+
+	total = ptr_dev_info_t->device_size / ptr_dev_info_t->erase_size;
+	pool = total * pool_percent / 100;
+	if (!pool || pool > _SPI_NAND_BMT_MAX_SIZE || pool >= total) {
+		printf("BMT: pool of %u blocks is not supported (%u blocks max)\n", pool, _SPI_NAND_BMT_MAX_SIZE);
+		return -1;
+	}
+	system = total - pool;
+
+	/* The table lives in the first page of the last good pool block */
+	for (block = total - 1; block >= system; block--) {
+		if (SPI_NAND_Flash_Read_Random((u64)block * ptr_dev_info_t->erase_size, buf, sizeof(buf),
+				ptr_dev_info_t->read_mode) != SPI_NAND_FLASH_RTN_NO_ERROR)
+			continue;
+		if (memcmp(buf, "BMT", 3) || (buf[3] != _SPI_NAND_BMT_VERSION) || (buf[5] > pool))
+			continue;
+		goto found;
 	}
+	printf("BMT: no table found in the last %u blocks\n", pool);
 	return -1;
+
+found:
+	mapped = buf[5];
+	checksum = buf[3] + buf[5];
+	for (i = 0; i < pool * _SPI_NAND_BMT_ENTRY_SIZE; i++)
+		checksum += buf[_SPI_NAND_BMT_HEADER_SIZE + i];
+	if (checksum != buf[6]) {
+		printf("BMT: checksum mismatch in block 0x%x, the pool size is probably not %u%%\n", block, pool_percent);
+		return -1;
+	}
+
+	_bmt_map = (u32 *)malloc(system * sizeof(u32));
+	if (!_bmt_map) {
+		printf("BMT: out of memory\n");
+		return -1;
+	}
+	for (i = 0; i < system; i++)
+		_bmt_map[i] = i;
+
+	/* Later entries win, a pool block that went bad is remapped again */
+	for (i = 0; i < mapped; i++) {
+		entry = &buf[_SPI_NAND_BMT_HEADER_SIZE + i * _SPI_NAND_BMT_ENTRY_SIZE];
+		bad = entry[0] | (entry[1] << 8);
+		good = entry[2] | (entry[3] << 8);
+		if (bad >= system || good < system || good >= total) {
+			printf("BMT: ignoring entry %u, block 0x%x -> 0x%x\n", i, bad, good);
+			continue;
+		}
+		_bmt_map[bad] = good;
+	}
+	_bmt_system_blocks = system;
+	SPI_NAND_Flash_Clear_Read_Cache_Data();
+
+	printf("BMT: table in block 0x%x, %u of %u pool blocks mapped\n", block, mapped, pool);
+
+	return (long long)system * ptr_dev_info_t->erase_size;
+}
+
+/* Data and spare sizes of one page of a raw (-d) image */
+int snand_raw_layout(unsigned int *page_size, unsigned int *oob_size)
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+	u32 pages_per_block;
+
+	if( ECC_fcheck || !ptr_dev_info_t->page_size )
+		return -1;
+
+	pages_per_block = ptr_dev_info_t->erase_size / ptr_dev_info_t->page_size;
+	*oob_size = erase_oob_size / pages_per_block;
+	*page_size = ptr_dev_info_t->page_size - *oob_size;
+
+	return 0;
 }
 
 void support_snand_list(void)
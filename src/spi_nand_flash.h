@@ -14,8 +14,10 @@
  *      SPI_NAND_Flash_Write_Nbyte      To provide interface for Write N Bytes into SPI NAND Flash.
  *      SPI_NAND_Flash_Read_NByte       To provide interface for Read N Bytes from SPI NAND Flash.
  *      SPI_NAND_Flash_Erase            To provide interface for Erase SPI NAND Flash.
+ *      SPI_NAND_Flash_Relocate_Block   To provide interface for move a block inside SPI NAND Flash.
  *      SPI_NAND_Flash_Read_Byte        To provide interface for read 1 Bytes from SPI NAND Flash.
  *      SPI_NAND_Flash_Read_DWord       To provide interface for read Double Word from SPI NAND Flash.
+ *      SPI_NAND_Flash_Read_Random      To provide interface for read a few Bytes at any address.
  *
  * DEPENDENCIES
  *
@@ -78,6 +80,7 @@ typedef enum{
 #define SPI_NAND_FLASH_PLANE_SELECT_HAVE	( 0x01 << 0 )
 #define SPI_NAND_FLASH_DIE_SELECT_1_HAVE	( 0x01 << 1 )
 #define SPI_NAND_FLASH_DIE_SELECT_2_HAVE	( 0x01 << 2 )
+#define SPI_NAND_FLASH_MULTI_PLANE_PROGRAM_HAVE	( 0x01 << 3 )
 
 struct spi_nand_flash_oobfree{
 	unsigned long offset;
@@ -89,6 +92,15 @@ struct spi_nand_flash_ooblayout
 	struct spi_nand_flash_oobfree oobfree[SPI_NAND_FLASH_OOB_FREE_ENTRY_MAX];
 };
 
+/* ECC status in status register 3 is ((status & mask) >> shift) */
+struct spi_nand_flash_ecc_status
+{
+	u8	mask;
+	u8	shift;
+	u8	fail;		/* value reported for an uncorrectable page */
+	u8	bitflips[16];	/* worst case corrected bitflips for each value */
+};
+
 struct SPI_NAND_FLASH_INFO_T {
 	u8					mfr_id;
 	u8					dev_id;
@@ -101,7 +113,9 @@ struct SPI_NAND_FLASH_INFO_T {
 	SPI_NAND_FLASH_READ_SPEED_MODE_T	read_mode;
 	SPI_NAND_FLASH_WRITE_SPEED_MODE_T	write_mode;
 	struct spi_nand_flash_ooblayout		*oob_free_layout;
+	const struct spi_nand_flash_ecc_status	*ecc_status;	/* NULL if not checked */
 	u32					feature;
+	u8					nop;		/* programs allowed per page between erases, 0 means 1 */
 };
 
 struct nand_info {
@@ -162,9 +176,9 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Init( u32   rom_base );
 SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Get_Flash_Info( struct SPI_NAND_FLASH_INFO_T *ptr_rtn_into_t);
 
 /*------------------------------------------------------------------------------------
- * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Write_Nbyte( u32    dst_addr,
- *                                                            u32    len,
- *                                                            u32    *ptr_rtn_len,
+ * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Write_Nbyte( u64    dst_addr,
+ *                                                            u64    len,
+ *                                                            u64    *ptr_rtn_len,
  *                                                            u8*    ptr_buf      )
  * PURPOSE : To provide interface for Write N Bytes into SPI NAND Flash.
  * AUTHOR  :
@@ -183,9 +197,9 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Get_Flash_Info( struct SPI_NAND_FLASH_INFO_T
  *
  *------------------------------------------------------------------------------------
  */
-SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Write_Nbyte( u32					dst_addr,
-                                                 u32					len,
-                                                 u32					*ptr_rtn_len,
+SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Write_Nbyte( u64					dst_addr,
+                                                 u64					len,
+                                                 u64					*ptr_rtn_len,
                                                  u8					*ptr_buf,
                                                  SPI_NAND_FLASH_WRITE_SPEED_MODE_T	speed_mode );
 
@@ -212,16 +226,16 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Write_Nbyte( u32					dst_addr,
  *
  *------------------------------------------------------------------------------------
  */
-u32 SPI_NAND_Flash_Read_NByte( u32					addr,
-                               u32					len,
-                               u32					*retlen,
+u32 SPI_NAND_Flash_Read_NByte( u64					addr,
+                               u64					len,
+                               u64					*retlen,
                                u8					*buf,
                                SPI_NAND_FLASH_READ_SPEED_MODE_T		speed_mode,
                                SPI_NAND_FLASH_RTN_T			*status );
 
 /*------------------------------------------------------------------------------------
- * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Erase( u32  dst_addr,
- *                                                      u32  len      )
+ * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Erase( u64  dst_addr,
+ *                                                      u64  len      )
  * PURPOSE : To provide interface for Erase SPI NAND Flash.
  * AUTHOR  :
  * CALLED BY
@@ -238,8 +252,57 @@ u32 SPI_NAND_Flash_Read_NByte( u32					addr,
  *
  *------------------------------------------------------------------------------------
  */
-SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Erase( u32  dst_addr,
-                                           u32  len      );
+SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Erase( u64  dst_addr,
+                                           u64  len      );
+
+/*------------------------------------------------------------------------------------
+ * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Relocate_Block( u32 src_block,
+ *                                                               u32 dst_block )
+ * PURPOSE : To move one block to another block inside SPI NAND Flash.
+ * AUTHOR  :
+ * CALLED BY
+ *   -
+ * CALLS
+ *   -
+ * PARAMs  :
+ *   INPUT : src_block - The src_block variable of this function.
+ *           dst_block - The dst_block variable of this function.
+ *   OUTPUT: None
+ * RETURN  : SPI_RTN_NO_ERROR - Successful.   Otherwise - Failed.
+ * NOTES   : The destination block is erased, then every page is copied with
+ *           internal copy-back, so no data crosses the SPI bus. Both blocks
+ *           must be on the same die, and on the same plane for chips with
+ *           SPI_NAND_FLASH_PLANE_SELECT_HAVE.
+ * MODIFICTION HISTORY:
+ *
+ *------------------------------------------------------------------------------------
+ */
+SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Relocate_Block( u32 src_block, u32 dst_block );
+
+/*------------------------------------------------------------------------------------
+ * FUNCTION: SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Read_Random( u64 addr,
+ *                                                            u8  *ptr_rtn_buf,
+ *                                                            u32 len,
+ *                                                            SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode )
+ * PURPOSE : To read a few bytes at an arbitrary address from SPI NAND Flash.
+ * AUTHOR  :
+ * CALLED BY
+ *   -
+ * CALLS
+ *   -
+ * PARAMs  :
+ *   INPUT : addr       - The addr variable of this function.
+ *           len        - The len variable of this function.
+ *           speed_mode - The speed_mode variable of this function.
+ *   OUTPUT: ptr_rtn_buf - A pointer to the ptr_rtn_buf variable.
+ * RETURN  : SPI_RTN_NO_ERROR - Successful.   Otherwise - Failed.
+ * NOTES   : Each page is loaded with PAGE READ once and only the requested
+ *           columns are shifted out of the chip cache. No progress output.
+ * MODIFICTION HISTORY:
+ *
+ *------------------------------------------------------------------------------------
+ */
+SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Read_Random( u64 addr, u8 *ptr_rtn_buf, u32 len, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode );
 
 /*------------------------------------------------------------------------------------
  * FUNCTION: char SPI_NAND_Flash_Read_Byte( long     addr )
@@ -299,9 +362,14 @@ unsigned long SPI_NAND_Flash_Read_DWord( unsigned long  addr, SPI_NAND_FLASH_RTN
  */
 void SPI_NAND_Flash_Clear_Read_Cache_Data( void );
 
+u32 SPI_NAND_Flash_Get_Page_Bitflips( void );
+
 SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Enable_OnDie_ECC( void );
 
 SPI_NAND_FLASH_RTN_T spi_nand_erase_block ( u32 block_index);
 
+/* Blocks which failed in the last erase, one bit per block; returns the count */
+u32 SPI_NAND_Flash_Get_Erase_Fail_Map( const u8 **ptr_rtn_map );
+
 #endif /* ifndef __SPI_NAND_FLASH_H__ */
 /* End of [spi_nand_flash.h] package */
@@ -21,9 +21,10 @@
 #include <unistd.h>
 #include <stdbool.h>
 #include "spi_controller.h"
-#include "snorcmd_api.h"
+#include "flashcmd_api.h"
 #include "types.h"
 #include "timer.h"
+#include "blank_check.h"
 
 #define min(a,b) (((a)<(b))?(a):(b))
 
@@ -53,6 +54,7 @@
 
 #define OPCODE_P4E			0x20	/* 4KB Parameter Sectore Erase */
 #define OPCODE_P8E			0x40	/* 8KB Parameter Sectore Erase */
+#define OPCODE_BE32K			0x52	/* 32KB Block Erase */
 #define OPCODE_BE			0x60	/* Bulk Erase */
 #define OPCODE_BE1			0xC7	/* Bulk Erase */
 #define OPCODE_QPP			0x32	/* Quad Page Programing */
@@ -63,6 +65,21 @@
 #define OPCODE_BRRD			0x16
 #define OPCODE_BRWR			0x17
 
+#define OPCODE_RDSFDP			0x5A	/* Read SFDP */
+#define OPCODE_RUID			0x4B	/* Read Unique ID */
+
+/* 4-byte address opcodes, independent of the address mode */
+#define OPCODE_READ4B			0x13	/* Read data bytes */
+#define OPCODE_FAST_READ4B		0x0C	/* Fast Read */
+#define OPCODE_PP4B			0x12	/* Page program */
+#define OPCODE_SE4B			0xDC	/* Sector erase */
+#define OPCODE_BE32K4B			0x5C	/* 32KB Block Erase */
+#define OPCODE_P4E4B			0x21	/* 4KB Parameter Sector Erase */
+
+/* chip_info.addr4b */
+#define ADDR4B_MODE			1	/* 4-byte addresses after EN4B (B7h) */
+#define ADDR4B_NATIVE			2	/* 4-byte addresses with the dedicated opcodes */
+
 /* Status Register bits. */
 #define SR_WIP				1	/* Write in progress */
 #define SR_WEL				2	/* Write enable latch */
@@ -77,6 +94,23 @@
 
 #define udelay(x)			usleep(x)
 
+#define SNOR_ERASE_TYPES		4
+
+struct snor_erase_type {
+	u32		size;		/* bytes, 0 if the type is not used */
+	u8		opcode;
+	u8		opcode4b;	/* for ADDR4B_NATIVE */
+	u32		time_ms;	/* typical, 0 if unknown */
+};
+
+/* chip_info.read_modes, (command-address-data) lines */
+#define SNOR_READ_1_1_2			(1 << 0)
+#define SNOR_READ_1_2_2			(1 << 1)
+#define SNOR_READ_2_2_2			(1 << 2)
+#define SNOR_READ_1_1_4			(1 << 3)
+#define SNOR_READ_1_4_4			(1 << 4)
+#define SNOR_READ_4_4_4			(1 << 5)
+
 struct chip_info {
 	char		*name;
 	u8		id;
@@ -84,6 +118,16 @@ struct chip_info {
 	unsigned long	sector_size;
 	unsigned int	n_sectors;
 	char		addr4b;
+
+	/* Filled in from SFDP, or defaulted by chip_prob() for table entries */
+	u32		page_size;
+	struct snor_erase_type erase[SNOR_ERASE_TYPES];
+	u8		sector_erase;	/* erase[] index used for sector_size */
+	u8		erase_time_mult;	/* typical to maximum erase time */
+	u32		page_program_us;
+	u32		chip_erase_ms;
+	u8		read_modes;
+	bool		sfdp;
 };
 
 struct chip_info *spi_chip_info;
@@ -132,30 +176,51 @@ static inline int snor_unprotect(void)
 	return 0;
 }
 
+#define SNOR_SR_BURST			31	/* status bytes per poll, one CH341A USB packet */
+#define SNOR_SR_FAST_POLLS		16	/* bursts before sleeping between them */
+
 /*
  * Service routine to read status register until ready, or timeout occurs.
+ * RDSR is sent once; with CS held the chip keeps returning the status
+ * register, so each transfer brings SNOR_SR_BURST fresh samples.
  * Returns non-zero if error.
  */
 static int snor_wait_ready(int sleep_ms)
 {
-	int count;
-	int sr = 0;
+	u8 sr[SNOR_SR_BURST];
+	int count, i, ret = -1;
+
+	SPI_CONTROLLER_Chip_Select_Low();
+	if (SPI_CONTROLLER_Write_One_Byte(OPCODE_RDSR)) {
+		SPI_CONTROLLER_Chip_Select_High();
+		printf("%s: read_sr fail\n", __func__);
+		return -1;
+	}
 
 	/* one chip guarantees max 5 msec wait here after page writes,
 	 * but potentially three seconds (!) after page erase.
 	 */
+	sr[SNOR_SR_BURST - 1] = 0;
 	for (count = 0; count < ((sleep_ms + 1) * 1000); count++) {
-		if ((snor_read_sr((u8 *)&sr)) < 0)
+		if (SPI_CONTROLLER_Read_NByte(sr, sizeof(sr), SPI_CONTROLLER_SPEED_SINGLE))
+			break;
+		for (i = 0; i < SNOR_SR_BURST; i++) {
+			if (!(sr[i] & (SR_WIP | SR_EPE)))
+				break;
+		}
+		if (i < SNOR_SR_BURST) {
+			ret = 0;
 			break;
-		//| SR_WEL
-		else if (!(sr & (SR_WIP | SR_EPE))) {
-			return 0;
 		}
-		udelay(500);
-		/* REVISIT sometimes sleeping would be best */
+		/* long erases: no need to keep the bus busy */
+		if (count >= SNOR_SR_FAST_POLLS)
+			udelay(500);
 	}
-	printf("%s: read_sr fail: %x\n", __func__, sr);
-	return -1;
+	SPI_CONTROLLER_Chip_Select_High();
+
+	if (ret)
+		printf("%s: read_sr fail: %x\n", __func__, sr[SNOR_SR_BURST - 1]);
+	return ret;
 }
 
 /*
@@ -235,42 +300,75 @@ static int snor_4byte_mode(int enable)
 }
 
 /*
- * Erase one sector of flash memory at offset ``offset'' which is any
- * address within the sector which should be erased.
+ * Parts that only take 4-byte addresses in 4-byte mode are switched once
+ * per operation, parts with the dedicated opcodes are never switched.
+ */
+static inline void snor_addr_mode_begin(void)
+{
+	if (spi_chip_info->addr4b == ADDR4B_MODE)
+		snor_4byte_mode(1);
+}
+
+static inline void snor_addr_mode_end(void)
+{
+	if (spi_chip_info->addr4b == ADDR4B_MODE)
+		snor_4byte_mode(0);
+}
+
+/*
+ * Build opcode plus address for the current addressing scheme into cmd,
+ * which must hold 5 bytes. Returns the number of bytes to send.
+ */
+static int snor_cmd_addr(u8 *cmd, u8 opcode, unsigned long long addr)
+{
+	int n = 0;
+
+	if (spi_chip_info->addr4b == ADDR4B_NATIVE) {
+		switch (opcode) {
+		case OPCODE_READ:	opcode = OPCODE_READ4B; break;
+		case OPCODE_FAST_READ:	opcode = OPCODE_FAST_READ4B; break;
+		case OPCODE_PP:		opcode = OPCODE_PP4B; break;
+		}
+	}
+
+	cmd[n++] = opcode;
+	if (spi_chip_info->addr4b)
+		cmd[n++] = (addr >> 24) & 0xff;
+	cmd[n++] = (addr >> 16) & 0xff;
+	cmd[n++] = (addr >> 8) & 0xff;
+	cmd[n++] = addr & 0xff;
+
+	return n;
+}
+
+/*
+ * Erase one block of type ``et'' at offset ``offset'' which is any
+ * address within the block which should be erased.
  *
  * Returns 0 if successful, non-zero otherwise.
  */
-static int snor_erase_sector(unsigned long offset)
+static int snor_erase_block(const struct snor_erase_type *et, unsigned long long offset)
 {
-	snor_dbg("%s: offset:%x\n", __func__, offset);
+	u8 cmd[5];
+	int n;
+
+	snor_dbg("%s: offset:%llx size:%x\n", __func__, offset, et->size);
 
 	/* Wait until finished previous write command. */
 	if (snor_wait_ready(950))
 		return -1;
 
-	if (spi_chip_info->addr4b) {
-		snor_4byte_mode(1);
-	}
-
 	/* Send write enable, then erase commands. */
 	snor_write_enable();
 
-	SPI_CONTROLLER_Chip_Select_Low();
-
-	SPI_CONTROLLER_Write_One_Byte(OPCODE_SE);
-	if (spi_chip_info->addr4b)
-		SPI_CONTROLLER_Write_One_Byte((offset >> 24) & 0xff);
-	SPI_CONTROLLER_Write_One_Byte((offset >> 16) & 0xff);
-	SPI_CONTROLLER_Write_One_Byte((offset >> 8) & 0xff);
-	SPI_CONTROLLER_Write_One_Byte(offset & 0xff);
+	n = snor_cmd_addr(cmd, spi_chip_info->addr4b == ADDR4B_NATIVE ? et->opcode4b : et->opcode, offset);
 
+	SPI_CONTROLLER_Chip_Select_Low();
+	SPI_CONTROLLER_Write_NByte(cmd, n, SPI_CONTROLLER_SPEED_SINGLE);
 	SPI_CONTROLLER_Chip_Select_High();
 
 	snor_wait_ready(950);
 
-	if (spi_chip_info->addr4b)
-		snor_4byte_mode(0);
-
 	return 0;
 }
 
@@ -312,14 +410,14 @@ static struct chip_info chips_data [] = {
 	{ "GD25Q32",		0xc8, 0x40160000, 64 * 1024, 64,  0 },
 	{ "GD25Q64CSIG",	0xc8, 0x4017c840, 64 * 1024, 128, 0 },
 	{ "GD25Q128CSIG",	0xc8, 0x4018c840, 64 * 1024, 256, 0 },
-	{ "GD25Q256CSIG",	0xc8, 0x4019c840, 64 * 1024, 512, 1 },
+	{ "GD25Q256CSIG",	0xc8, 0x4019c840, 64 * 1024, 512, ADDR4B_NATIVE },
 
 	{ "MX25L1605D",		0xc2, 0x2015c220, 64 * 1024, 32,  0 },
 	{ "MX25L3205D",		0xc2, 0x2016c220, 64 * 1024, 64,  0 },
 	{ "MX25L6405D",		0xc2, 0x2017c220, 64 * 1024, 128, 0 },
 	{ "MX25L12805D",	0xc2, 0x2018c220, 64 * 1024, 256, 0 },
 	{ "MX25L25635E",	0xc2, 0x2019c220, 64 * 1024, 512, 1 },
-	{ "MX25L51245G",	0xc2, 0x201ac220, 64 * 1024, 1024, 1 },
+	{ "MX25L51245G",	0xc2, 0x201ac220, 64 * 1024, 1024, ADDR4B_NATIVE },
 
 	{ "FL016AIF",		0x01, 0x02140000, 64 * 1024, 32,  0 },
 	{ "FL064AIF",		0x01, 0x02160000, 64 * 1024, 128, 0 },
@@ -327,7 +425,7 @@ static struct chip_info chips_data [] = {
 	{ "S25FL064P",		0x01, 0x02164D00, 64 * 1024, 128, 0 },
 	{ "S25FL128P",		0x01, 0x20180301, 64 * 1024, 256, 0 },
 	{ "S25FL129P",		0x01, 0x20184D01, 64 * 1024, 256, 0 },
-	{ "S25FL256S",		0x01, 0x02194D01, 64 * 1024, 512, 1 },
+	{ "S25FL256S",		0x01, 0x02194D01, 64 * 1024, 512, ADDR4B_NATIVE },
 	{ "S25FL116K",		0x01, 0x40150140, 64 * 1024, 32,  0 },
 	{ "S25FL132K",		0x01, 0x40160140, 64 * 1024, 64,  0 },
 	{ "S25FL164K",		0x01, 0x40170140, 64 * 1024, 128, 0 },
@@ -367,7 +465,7 @@ static struct chip_info chips_data [] = {
 	{ "W25Q128BV",		0xef, 0x40180000, 64 * 1024, 256, 0 },
 	{ "W25Q128FW",		0xef, 0x60180000, 64 * 1024, 256, 0 },
 	{ "W25Q256FV",		0xef, 0x40190000, 64 * 1024, 512, 1 },
-	{ "W25Q512JV",		0xef, 0x71190000, 64 * 1024, 1024, 1 },
+	{ "W25Q512JV",		0xef, 0x71190000, 64 * 1024, 1024, ADDR4B_NATIVE },
 
 	{ "M25P016",		0x20, 0x20150000, 64 * 1024, 32,  0 },
 	{ "N25Q032A",		0x20, 0xba161000, 64 * 1024, 64,  0 },
@@ -378,8 +476,8 @@ static struct chip_info chips_data [] = {
 	{ "XM25QH32A",		0x20, 0x70160000, 64 * 1024, 64,  0 },
 	{ "XM25QH64A",		0x20, 0x70170000, 64 * 1024, 128, 0 },
 	{ "XM25QH128A",		0x20, 0x70182070, 64 * 1024, 256, 0 },
-	{ "N25Q256A",		0x20, 0xba191000, 64 * 1024, 512, 1 },
-	{ "MT25QL512AB",	0x20, 0xba201044, 64 * 1024, 1024, 1 },
+	{ "N25Q256A",		0x20, 0xba191000, 64 * 1024, 512, ADDR4B_NATIVE },
+	{ "MT25QL512AB",	0x20, 0xba201044, 64 * 1024, 1024, ADDR4B_NATIVE },
 
 	{ "ZB25VQ16",		0x5e, 0x40150000, 64 * 1024, 32,  0 },
 	{ "ZB25VQ32",		0x5e, 0x40160000, 64 * 1024, 64,  0 },
@@ -490,43 +588,387 @@ static int snor_write_sr(u8 *val)
 	return 0;
 }
 
+/*
+ * SFDP (JESD216) discovery
+ */
+#define SFDP_SIGNATURE			0x50444653	/* "SFDP" */
+#define SFDP_BFPT_ID			0xff00	/* Basic Flash Parameter Table */
+#define SFDP_4BAIT_ID			0xff84	/* 4-byte Address Instruction Table */
+#define SFDP_BFPT_MIN_DWORDS		9	/* JESD216, later revisions only append */
+#define SFDP_BFPT_MAX_DWORDS		16
+
+static int snor_read_sfdp(u32 addr, u8 *buf, u32 len)
+{
+	u8 cmd[5] = { OPCODE_RDSFDP, (addr >> 16) & 0xff, (addr >> 8) & 0xff, addr & 0xff, 0 /* dummy */ };
+	int retval;
+
+	SPI_CONTROLLER_Chip_Select_Low();
+	retval = SPI_CONTROLLER_Write_NByte(cmd, sizeof(cmd), SPI_CONTROLLER_SPEED_SINGLE);
+	if (!retval)
+		retval = SPI_CONTROLLER_Read_NByte(buf, len, SPI_CONTROLLER_SPEED_SINGLE);
+	SPI_CONTROLLER_Chip_Select_High();
+
+	return retval;
+}
+
+/* DWORDs are numbered from 1, as in JESD216 */
+static u32 sfdp_dword(const u8 *tbl, int n)
+{
+	tbl += (n - 1) * 4;
+	return (u32)tbl[0] | ((u32)tbl[1] << 8) | ((u32)tbl[2] << 16) | ((u32)tbl[3] << 24);
+}
+
+/*
+ * Read the Basic Flash Parameter Table and, if present, the 4-byte address
+ * instruction table, and fill in info. Fields the tables do not describe
+ * are left as they are. Returns 0 if the chip has a usable SFDP.
+ */
+static int snor_sfdp_parse(struct chip_info *info)
+{
+	static const u32 erase_units_ms[] = { 1, 16, 128, 1000 };
+	static const u32 chip_units_ms[] = { 16, 256, 4000, 64000 };
+	u8 hdr[8], bfpt[SFDP_BFPT_MAX_DWORDS * 4], ait[8];
+	u32 bfpt_addr = 0, ait_addr = 0, dw, ait_dw1 = 0, ait_dw2 = 0;
+	unsigned long long size;
+	int i, nph, bfpt_len = 0, type, best = -1;
+
+	if (snor_read_sfdp(0, hdr, sizeof(hdr)) || sfdp_dword(hdr, 1) != SFDP_SIGNATURE || hdr[5] != 1)
+		return -1;
+
+	nph = hdr[6] + 1;
+	for (i = 0; i < nph; i++) {
+		u16 id;
+
+		if (snor_read_sfdp(8 + i * 8, hdr, sizeof(hdr)))
+			return -1;
+		id = (hdr[7] << 8) | hdr[0];
+		if (id == SFDP_BFPT_ID && !bfpt_len) {
+			bfpt_addr = hdr[4] | (hdr[5] << 8) | (hdr[6] << 16);
+			bfpt_len = min(hdr[3], SFDP_BFPT_MAX_DWORDS);
+		} else if (id == SFDP_4BAIT_ID && hdr[3] >= 2)
+			ait_addr = hdr[4] | (hdr[5] << 8) | (hdr[6] << 16);
+	}
+
+	if (bfpt_len < SFDP_BFPT_MIN_DWORDS)
+		return -1;
+
+	memset(bfpt, 0, sizeof(bfpt));
+	if (snor_read_sfdp(bfpt_addr, bfpt, bfpt_len * 4))
+		return -1;
+
+	/* DWORD 2: density in bits */
+	dw = sfdp_dword(bfpt, 2);
+	if (dw & 0x80000000) {
+		dw &= 0x7fffffff;
+		if (dw < 19 || dw > 35)
+			return -1;
+		size = 1ULL << (dw - 3);
+	} else
+		size = ((unsigned long long)dw + 1) >> 3;
+	if (size < 0x10000)
+		return -1;
+
+	/* DWORDs 8-9: erase types, DWORD 10: their typical times */
+	for (type = 0; type < SNOR_ERASE_TYPES; type++) {
+		dw = sfdp_dword(bfpt, 8 + type / 2) >> (16 * (type & 1));
+		memset(&info->erase[type], 0, sizeof(info->erase[type]));
+		if (!(dw & 0xff) || (dw & 0xff) > 24)
+			continue;
+		info->erase[type].size = 1UL << (dw & 0xff);
+		info->erase[type].opcode = (dw >> 8) & 0xff;
+		switch (info->erase[type].opcode) {
+		case OPCODE_P4E:	info->erase[type].opcode4b = OPCODE_P4E4B; break;
+		case OPCODE_BE32K:	info->erase[type].opcode4b = OPCODE_BE32K4B; break;
+		case OPCODE_SE:		info->erase[type].opcode4b = OPCODE_SE4B; break;
+		}
+		if (best < 0 || info->erase[type].size > info->erase[best].size)
+			best = type;
+	}
+	if (best < 0)
+		return -1;
+
+	if (bfpt_len >= 11) {
+		dw = sfdp_dword(bfpt, 10);
+		info->erase_time_mult = 2 * ((dw & 0xf) + 1);
+		for (type = 0; type < SNOR_ERASE_TYPES; type++) {
+			u32 t = dw >> (4 + 7 * type);
+			if (info->erase[type].size)
+				info->erase[type].time_ms = ((t & 0x1f) + 1) * erase_units_ms[(t >> 5) & 3];
+		}
+
+		/* DWORD 11: page size, page program and chip erase times */
+		dw = sfdp_dword(bfpt, 11);
+		info->page_size = 1 << ((dw >> 4) & 0xf);
+		info->page_program_us = (((dw >> 8) & 0x1f) + 1) * ((dw & (1 << 13)) ? 64 : 8);
+		info->chip_erase_ms = (((dw >> 24) & 0x1f) + 1) * chip_units_ms[(dw >> 29) & 3];
+	}
+
+	/* DWORDs 1 and 5: fast read modes */
+	dw = sfdp_dword(bfpt, 1);
+	info->read_modes = ((dw & (1 << 16)) ? SNOR_READ_1_1_2 : 0) |
+			   ((dw & (1 << 20)) ? SNOR_READ_1_2_2 : 0) |
+			   ((dw & (1 << 21)) ? SNOR_READ_1_4_4 : 0) |
+			   ((dw & (1 << 22)) ? SNOR_READ_1_1_4 : 0);
+	dw = sfdp_dword(bfpt, 5);
+	info->read_modes |= ((dw & (1 << 0)) ? SNOR_READ_2_2_2 : 0) |
+			    ((dw & (1 << 4)) ? SNOR_READ_4_4_4 : 0);
+
+	/* 4-byte address instruction table: READ4B 13h, PP4B 12h and per type erase opcodes */
+	if (ait_addr && !snor_read_sfdp(ait_addr, ait, sizeof(ait))) {
+		ait_dw1 = sfdp_dword(ait, 1);
+		ait_dw2 = sfdp_dword(ait, 2);
+		for (type = 0; type < SNOR_ERASE_TYPES; type++)
+			if (ait_dw1 & (1 << (9 + type)))
+				info->erase[type].opcode4b = (ait_dw2 >> (8 * type)) & 0xff;
+	}
+
+	/* a table entry keeps its sector size if the chip can erase it */
+	for (type = 0; type < SNOR_ERASE_TYPES; type++)
+		if (info->sector_size && info->erase[type].size == info->sector_size)
+			best = type;
+	info->sector_erase = best;
+	info->sector_size = info->erase[best].size;
+	info->n_sectors = size / info->sector_size;
+
+	if (size <= 0x1000000)
+		info->addr4b = 0;
+	else if ((ait_dw1 & 0x1) && (ait_dw1 & (1 << 6)) && (ait_dw1 & (1 << (9 + best))))
+		info->addr4b = ADDR4B_NATIVE;
+	else if (info->addr4b != ADDR4B_NATIVE)
+		info->addr4b = ADDR4B_MODE;
+
+	if (!info->page_size)
+		info->page_size = FLASH_PAGESIZE;
+	info->sfdp = true;
+
+	return 0;
+}
+
+#define CHIP_ID_HASH_SIZE	512	/* power of two, above twice the table size */
+
+/*
+ * Index + 1 of every chips_data entry, open addressing on the 3-byte
+ * JEDEC ID (id, jedec_id >> 16), 0 if empty. Entries sharing an ID sit
+ * in the probe sequence in table order and are told apart by the
+ * extended bytes.
+ */
+static u16 chip_id_hash[CHIP_ID_HASH_SIZE];
+static bool chip_id_hashed = false;
+
+static u32 chip_id_key(u8 id, u32 jedec)
+{
+	return ((u32)id << 16) | (jedec >> 16);
+}
+
+static u32 chip_id_hash_slot(u32 key)
+{
+	return (key * 2654435761U) >> 23;
+}
+
+/*
+ * Match the full ID first, then a table entry that leaves the extended
+ * bytes as don't care (zero), then any entry with the same 3-byte ID.
+ */
+static struct chip_info *chip_lookup(u8 id, u32 jedec)
+{
+	struct chip_info *info, *wild = NULL, *any = NULL;
+	u32 key, slot;
+	int i;
+
+	if (!chip_id_hashed) {
+		for (i = 0; i < sizeof(chips_data)/sizeof(chips_data[0]); i++) {
+			slot = chip_id_hash_slot(chip_id_key(chips_data[i].id, chips_data[i].jedec_id));
+			while (chip_id_hash[slot])
+				slot = (slot + 1) & (CHIP_ID_HASH_SIZE - 1);
+			chip_id_hash[slot] = i + 1;
+		}
+		chip_id_hashed = true;
+	}
+
+	key = chip_id_key(id, jedec);
+	for (slot = chip_id_hash_slot(key); chip_id_hash[slot]; slot = (slot + 1) & (CHIP_ID_HASH_SIZE - 1)) {
+		info = &chips_data[chip_id_hash[slot] - 1];
+		if (chip_id_key(info->id, info->jedec_id) != key)
+			continue;
+		if (info->jedec_id == jedec)
+			return info;
+		if (!wild && !(info->jedec_id & 0xffff))
+			wild = info;
+		if (!any)
+			any = info;
+	}
+
+	return wild ? wild : any;
+}
+
+static u32 chip_jedec(const u8 *buf)
+{
+	return (u32)((u32)(buf[1] << 24) | ((u32)buf[2] << 16) | ((u32)buf[3] <<8) | (u32)buf[4]);
+}
+
+int snor_match_id(const unsigned char *buf)
+{
+	return chip_lookup(buf[0], chip_jedec(buf)) != NULL;
+}
+
+int snor_generic = 0;
+
+/* What an unknown ID most likely is */
+struct snor_suggestion {
+	const struct chip_info	*closest;	/* nearest table entry of the same vendor */
+	unsigned long long	size;		/* from the density byte, 0 if it makes no sense */
+};
+
+static void snor_near_match(const u8 *buf, struct snor_suggestion *sug)
+{
+	int i, score, best = 0, density = buf[2];
+
+	memset(sug, 0, sizeof(*sug));
+
+	for (i = 0; i < sizeof(chips_data)/sizeof(chips_data[0]); i++) {
+		const struct chip_info *c = &chips_data[i];
+
+		if (c->id != buf[0])
+			continue;
+		/* memory type and density bytes weigh most, then the nearest density */
+		score = 64 * (1 + 2 * (((c->jedec_id >> 24) & 0xff) == buf[1]) +
+			2 * (((c->jedec_id >> 16) & 0xff) == buf[2]) +
+			(((c->jedec_id >> 8) & 0xff) == buf[3]) + ((c->jedec_id & 0xff) == buf[4])) -
+			abs((int)((c->jedec_id >> 16) & 0xff) - buf[2]);
+		if (score > best) {
+			best = score;
+			sug->closest = c;
+		}
+	}
+
+	/* log2 of the size in bytes; 512 Mbit and up count on from 20h */
+	if (density >= 0x20 && density <= 0x22)
+		density = density - 0x20 + 26;
+	if (density >= 16 && density <= 28)
+		sug->size = 1ULL << density;
+}
+
+/* 64K D8h erase, 256-byte pages and plain READ/PP work on any SPI NOR */
+static void snor_generic_chip(struct chip_info *info, const struct snor_suggestion *sug)
+{
+	info->sector_size = 64 * 1024;
+	info->n_sectors = sug->size / info->sector_size;
+	info->addr4b = sug->size > 0x1000000 ? ADDR4B_MODE : 0;
+	info->page_size = FLASH_PAGESIZE;
+	info->erase[0].size = info->sector_size;
+	info->erase[0].opcode = OPCODE_SE;
+	info->erase[0].opcode4b = OPCODE_SE4B;
+}
+
+/* Working copy of the detected chip, SFDP may override the table entry */
+static struct chip_info snor_chip;
+static char snor_chip_name[24];
+
 struct chip_info *chip_prob(void)
 {
-	struct chip_info *info = NULL, *match = NULL;
-	u8 buf[5];
-	u32 jedec, jedec_strip, weight;
+	struct chip_info *info, probe;
+	u8 buf[FLASH_ID_LEN];
+	u32 jedec;
 	int i;
 
-	snor_read_devid(buf, 5);
-	jedec = (u32)((u32)(buf[1] << 24) | ((u32)buf[2] << 16) | ((u32)buf[3] <<8) | (u32)buf[4]);
-	jedec_strip = jedec & 0xffff0000;
+	if (flash_probe_id.valid)
+		memcpy(buf, flash_probe_id.raw, sizeof(buf));
+	else
+		snor_read_devid(buf, FLASH_ID_LEN);
+	jedec = chip_jedec(buf);
 
 	printf("spi device id: %x %x %x %x %x (%x)\n", buf[0], buf[1], buf[2], buf[3], buf[4], jedec);
 
-	// FIXME, assign default as AT25D
-	weight = 0xffffffff;
-	match = &chips_data[0];
-	for (i = 0; i < sizeof(chips_data)/sizeof(chips_data[0]); i++) {
-		info = &chips_data[i];
-		if (info->id == buf[0]) {
-			if ((info->jedec_id == jedec) || ((info->jedec_id & 0xffff0000) == jedec_strip)) {
-				printf("Detected SPI NOR Flash: %s, Flash Size: %ld MB\n", info->name, (info->sector_size * info->n_sectors) >> 20);
-				return info;
-			}
+	info = chip_lookup(buf[0], jedec);
+	if (info) {
+		snor_chip = *info;
+		snor_chip.page_size = FLASH_PAGESIZE;
+		snor_chip.erase[0].size = snor_chip.sector_size;
+		snor_chip.erase[0].opcode = OPCODE_SE;
+		snor_chip.erase[0].opcode4b = OPCODE_SE4B;
+	} else {
+		memset(&snor_chip, 0, sizeof(snor_chip));
+		snprintf(snor_chip_name, sizeof(snor_chip_name), "SFDP %02x%02x%02x", buf[0], buf[1], buf[2]);
+		snor_chip.name = snor_chip_name;
+		snor_chip.id = buf[0];
+		snor_chip.jedec_id = jedec;
+	}
 
-			if (weight > (info->jedec_id ^ jedec)) {
-				weight = info->jedec_id ^ jedec;
-				match = info;
-			}
+	probe = snor_chip;
+	if (!snor_sfdp_parse(&probe))
+		snor_chip = probe;
+	else if (!info) {
+		struct snor_suggestion sug;
+
+		if (buf[0] == 0x00 || buf[0] == 0xff) {
+			printf("SPI NOR Flash Not Detected!\n");
+			return NULL;
 		}
+
+		snor_near_match(buf, &sug);
+		if (!sug.size || !snor_generic)
+			printf("SPI NOR Flash Not Detected!\n");
+		if (sug.closest)
+			printf("Closest known chip: %s (%x %x)\n", sug.closest->name, sug.closest->id, sug.closest->jedec_id);
+		if (!sug.size)
+			return NULL;
+		printf("Density byte suggests %llu MB\n", sug.size >> 20);
+		if (!snor_generic) {
+			printf("Use -g to run it as a generic SPI NOR Flash\n");
+			return NULL;
+		}
+		printf("Unknown chip, assuming a generic SPI NOR Flash of %llu MB: 64K D8h erase, 256-byte pages\n",
+			sug.size >> 20);
+		snprintf(snor_chip_name, sizeof(snor_chip_name), "generic %02x%02x%02x", buf[0], buf[1], buf[2]);
+		snor_generic_chip(&snor_chip, &sug);
+	}
+	info = &snor_chip;
+
+	printf("Detected SPI NOR Flash: %s, Flash Size: %ld MB\n", info->name, (info->sector_size * info->n_sectors) >> 20);
+	if (info->sfdp) {
+		printf("SFDP: page %u bytes, %s addressing, erase", info->page_size,
+			info->addr4b == ADDR4B_NATIVE ? "4-byte opcode" : info->addr4b ? "4-byte mode" : "3-byte");
+		for (i = 0; i < SNOR_ERASE_TYPES; i++)
+			if (info->erase[i].size)
+				printf(" %luK/%02Xh", (unsigned long)info->erase[i].size >> 10, info->erase[i].opcode);
+		printf("\n");
 	}
-	printf("SPI NOR Flash Not Detected!\n");
-	match = NULL; /* Not support JEDEC calculate info */
 
-	return match;
+	return info;
+}
+
+/*
+ * Winbond and GigaDevice return the factory unique ID after 4Bh and four
+ * dummy bytes, 64 and 128 bits long. Returns the ID length, or -1.
+ */
+int snor_read_uid(unsigned char *uid, int len)
+{
+	u8 cmd[5] = { OPCODE_RUID, 0, 0, 0, 0 };
+	int n, retval;
+
+	if (spi_chip_info->id == 0xef)
+		n = 8;
+	else if (spi_chip_info->id == 0xc8)
+		n = 16;
+	else
+		return -1;
+	if (len < n || snor_wait_ready(1))
+		return -1;
+
+	SPI_CONTROLLER_Chip_Select_Low();
+	retval = SPI_CONTROLLER_Write_NByte(cmd, sizeof(cmd), SPI_CONTROLLER_SPEED_SINGLE);
+	if (!retval)
+		retval = SPI_CONTROLLER_Read_NByte(uid, n, SPI_CONTROLLER_SPEED_SINGLE);
+	SPI_CONTROLLER_Chip_Select_High();
+
+	/* parts without the command leave the bus floating */
+	if (retval || mem_is_blank(uid, n))
+		return -1;
+
+	return n;
 }
 
-long snor_init(void)
+long long snor_init(void)
 {
 	spi_chip_info = chip_prob();
 
@@ -535,127 +977,474 @@ long snor_init(void)
 
 	bsize = spi_chip_info->sector_size;
 
-	return spi_chip_info->sector_size * spi_chip_info->n_sectors;
+	return (long long)spi_chip_info->sector_size * spi_chip_info->n_sectors;
+}
+
+#define SNOR_READ_SPAN			0x10000	/* bytes clocked out per controller transfer */
+
+static void snor_read_stop(void)
+{
+	SPI_CONTROLLER_Chip_Select_High();
+}
+
+/*
+ * Send one READ with its address and leave CS asserted. The chip then
+ * streams the array out for as long as it is clocked, so callers pull
+ * any length with SPI_CONTROLLER_Read_NByte() and finish with
+ * snor_read_stop(). The address mode must already be set up.
+ */
+static int snor_read_start(unsigned long long addr)
+{
+	u8 cmd[5];
+	int n;
+
+	if (snor_wait_ready(1))
+		return -1;
+
+	n = snor_cmd_addr(cmd, OPCODE_READ, addr);
+
+	SPI_CONTROLLER_Chip_Select_Low();
+
+	if (SPI_CONTROLLER_Write_NByte(cmd, n, SPI_CONTROLLER_SPEED_SINGLE)) {
+		snor_read_stop();
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Stream the range out with one READ and stop at the first byte that is not 0xFF */
+static int snor_range_is_blank(unsigned long long offset, u32 size)
+{
+	unsigned char buf[4096];
+	u32 pos, chunk;
+	int blank = 1;
+
+	if (snor_read_start(offset))
+		return 0;
+
+	for (pos = 0; blank && pos < size; pos += chunk) {
+		chunk = min(sizeof(buf), size - pos);
+		if (SPI_CONTROLLER_Read_NByte(buf, chunk, SPI_CONTROLLER_SPEED_SINGLE))
+			blank = 0;
+		else
+			blank = mem_is_blank(buf, chunk);
+	}
+
+	snor_read_stop();
+
+	return blank;
 }
 
-int snor_erase(unsigned long offs, unsigned long len)
+int snor_erase_keep_edges = 0;
+
+#define SNOR_ERASE_CMD_MS		1	/* command and status polling cost per erase */
+
+/* Native 4-byte parts can only run the erase types that have a 4-byte opcode */
+static int snor_erase_usable(const struct snor_erase_type *et)
 {
-	unsigned long plen = len;
-	snor_dbg("%s: offs:%x len:%x\n", __func__, offs, len);
+	return et->size && (spi_chip_info->addr4b != ADDR4B_NATIVE || et->opcode4b);
+}
+
+/* Smallest erase size of the chip, the granularity of snor_erase() */
+unsigned int snor_erase_unit(void)
+{
+	u32 unit = spi_chip_info->sector_size;
+	int t;
+
+	for (t = 0; t < SNOR_ERASE_TYPES; t++)
+		if (snor_erase_usable(&spi_chip_info->erase[t]) && spi_chip_info->erase[t].size < unit)
+			unit = spi_chip_info->erase[t].size;
+
+	return unit;
+}
+
+/* Typical erase time, datasheet values of common parts if SFDP did not give one */
+static u32 snor_erase_time(const struct snor_erase_type *et)
+{
+	if (et->time_ms)
+		return et->time_ms + SNOR_ERASE_CMD_MS;
+	if (et->size <= 0x1000)
+		return 45 + SNOR_ERASE_CMD_MS;
+	if (et->size <= 0x8000)
+		return 120 + SNOR_ERASE_CMD_MS;
+	return 150 * (et->size >> 16) + SNOR_ERASE_CMD_MS;
+}
+
+/*
+ * Cover [start, start + n * unit) with naturally aligned erase blocks at
+ * the lowest total typical time. plan[] gets one erase type per block,
+ * in address order; returns the number of blocks, or -1.
+ */
+static long snor_erase_plan(unsigned long long start, u32 n, u32 unit, u8 *plan, unsigned long long *cost_ms)
+{
+	unsigned long long *cost;
+	u8 *choice;
+	u32 j, k;
+	long steps = 0;
+	int t;
+
+	cost = malloc((n + 1) * sizeof(*cost));
+	choice = malloc(n + 1);
+	if (!cost || !choice) {
+		free(cost);
+		free(choice);
+		return -1;
+	}
+
+	cost[0] = 0;
+	for (j = 1; j <= n; j++) {
+		cost[j] = ~0ULL;
+		for (t = 0; t < SNOR_ERASE_TYPES; t++) {
+			const struct snor_erase_type *et = &spi_chip_info->erase[t];
+
+			if (!snor_erase_usable(et))
+				continue;
+			k = et->size / unit;
+			if (k > j || ((start + (unsigned long long)(j - k) * unit) % et->size))
+				continue;
+			if (cost[j - k] + snor_erase_time(et) < cost[j]) {
+				cost[j] = cost[j - k] + snor_erase_time(et);
+				choice[j] = t;
+			}
+		}
+	}
+	*cost_ms = cost[n];
+	if (cost[n] == ~0ULL) {
+		printf("%s: no erase command of this chip covers the range\n", __func__);
+		free(cost);
+		free(choice);
+		return -1;
+	}
+
+	/* walk back from the end, then put the blocks in address order */
+	for (j = n; j > 0; j -= spi_chip_info->erase[choice[j]].size / unit)
+		plan[steps++] = choice[j];
+	for (k = 0; k < steps / 2; k++) {
+		u8 tmp = plan[k];
+		plan[k] = plan[steps - 1 - k];
+		plan[steps - 1 - k] = tmp;
+	}
+
+	free(cost);
+	free(choice);
+	return steps;
+}
+
+/*
+ * Erase [offs, offs + len). The range is split into the fastest mix of the
+ * chip's erase sizes; with snor_erase_keep_edges an unaligned range is
+ * widened to the erase unit and the data outside it is written back.
+ */
+int snor_erase(unsigned long long offs, unsigned long long len)
+{
+	unsigned long long chip_size = (unsigned long long)spi_chip_info->sector_size * spi_chip_info->n_sectors;
+	unsigned long long start, end, pos, cost_ms;
+	unsigned char *head = NULL, *tail = NULL;
+	u32 unit = snor_erase_unit(), head_len, tail_len, skipped = 0, count[SNOR_ERASE_TYPES] = { 0 };
+	u8 *plan;
+	long steps, i;
+	int t, ret = 0;
+	snor_dbg("%s: offs:%llx len:%llx\n", __func__, offs, len);
 
 	/* sanity checks */
-	if (len == 0)
+	if (len == 0 || offs + len > chip_size)
 		return -1;
 
-	if(!offs && len == (spi_chip_info->sector_size * spi_chip_info->n_sectors))
+	start = offs - offs % unit;
+	end = (offs + len + unit - 1) / unit * unit;
+	head_len = offs - start;
+	tail_len = end - (offs + len);
+
+	if ((head_len || tail_len) && !snor_erase_keep_edges) {
+		printf("Erase range must be aligned to 0x%x bytes\n", unit);
+		return -1;
+	}
+
+	plan = malloc((end - start) / unit);
+	if (!plan)
+		return -1;
+	steps = snor_erase_plan(start, (end - start) / unit, unit, plan, &cost_ms);
+	if (steps < 0) {
+		free(plan);
+		return -1;
+	}
+
+	if (!start && end == chip_size && !flash_erase_skip_blank &&
+	    (!spi_chip_info->chip_erase_ms || spi_chip_info->chip_erase_ms <= cost_ms))
 	{
+		free(plan);
 		printf("Please Wait......\n");
 		return full_erase_chip();
 	}
 
+	/* save the bytes that share an erase block with the range */
+	if (head_len && (!(head = malloc(head_len)) || snor_read(head, start, head_len) != head_len))
+		ret = -1;
+	if (!ret && tail_len && (!(tail = malloc(tail_len)) || snor_read(tail, offs + len, tail_len) != tail_len))
+		ret = -1;
+	if (ret) {
+		printf("Can't save the data around the erase range\n");
+		goto out;
+	}
+
+	for (i = 0; i < steps; i++)
+		count[plan[i]]++;
+	printf("Erase plan:");
+	for (t = 0; t < SNOR_ERASE_TYPES; t++)
+		if (count[t])
+			printf(" %u x %uK,", count[t], spi_chip_info->erase[t].size >> 10);
+	printf(" about %llu ms\n", cost_ms);
+
 	timer_start();
 
 	snor_unprotect();
+	snor_addr_mode_begin();
 
-	/* now erase those sectors */
-	while (len > 0) {
-		if (snor_erase_sector(offs)) {
-			return -1;
-		}
+	/* now erase those blocks */
+	for (i = 0, pos = start; i < steps; i++) {
+		const struct snor_erase_type *et = &spi_chip_info->erase[plan[i]];
 
-		offs += spi_chip_info->sector_size;
-		len -= spi_chip_info->sector_size;
+		if (flash_erase_skip_blank && snor_range_is_blank(pos, et->size))
+			skipped++;
+		else if (snor_erase_block(et, pos)) {
+			ret = -1;
+			break;
+		}
+		pos += et->size;
 
-		printf("\bErase %ld%% [%lu] of [%lu] bytes      ", 100 * (plen - len) / plen, plen - len, plen);
+		printf("\bErase %lld%% [%llu] of [%llu] bytes      ", 100 * (pos - start) / (end - start), pos - start, end - start);
 		printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 		fflush(stdout);
 	}
-	printf("Erase 100%% [%lu] of [%lu] bytes      \n", plen - len, plen);
+	snor_addr_mode_end();
+
+	if (ret)
+		goto out;
+
+	printf("Erase 100%% [%llu] of [%llu] bytes      \n", end - start, end - start);
+	if (skipped)
+		printf("Skipped %u blank blocks\n", skipped);
 	timer_end();
 
-	return 0;
+	if (head_len && snor_write(head, start, head_len) != head_len)
+		ret = -1;
+	if (tail_len && snor_write(tail, offs + len, tail_len) != tail_len)
+		ret = -1;
+	if (ret)
+		printf("Can't restore the data around the erase range\n");
+
+out:
+	free(head);
+	free(tail);
+	free(plan);
+	return ret;
 }
 
-int snor_read(unsigned char *buf, unsigned long from, unsigned long len)
+long long snor_read(unsigned char *buf, unsigned long long from, unsigned long long len)
 {
-	u32 read_addr, physical_read_addr, remain_len, data_offset;
-	unsigned transfer_sz = 4096;
+	unsigned long long remain_len;
+	u32 read_sz;
 
-	snor_dbg("%s: from:%x len:%x \n", __func__, from, len);
+	snor_dbg("%s: from:%llx len:%llx \n", __func__, from, len);
 
 	/* sanity checks */
 	if (len == 0)
 		return 0;
 
 	timer_start();
-	/* Wait till previous write/erase is done. */
-	if (snor_wait_ready(1)) {
-		/* REVISIT status return?? */
+	/* Wait till previous write/erase is done, then start one READ for the whole span. */
+	snor_addr_mode_begin();
+	if (snor_read_start(from)) {
+		snor_addr_mode_end();
 		return -1;
 	}
 
-	read_addr = from;
 	remain_len = len;
 
-	while(remain_len > 0) {
-		physical_read_addr = read_addr;
-		data_offset = (physical_read_addr % (spi_chip_info->sector_size));
+	while (remain_len > 0) {
+		read_sz = min(remain_len, SNOR_READ_SPAN);
+
+		if (SPI_CONTROLLER_Read_NByte(&buf[len - remain_len], read_sz, SPI_CONTROLLER_SPEED_SINGLE)) {
+			snor_read_stop();
+			snor_addr_mode_end();
+			printf("\n%s: transfer failed at 0x%llx\n", __func__, from + len - remain_len);
+			return -1;
+		}
 
-		if (spi_chip_info->addr4b)
-			snor_4byte_mode(1);
+		remain_len -= read_sz;
 
-		SPI_CONTROLLER_Chip_Select_Low();
+		printf("\bRead %lld%% [%llu] of [%llu] bytes      ", 100 * (len - remain_len) / len, len - remain_len, len);
+		printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+		fflush(stdout);
+	}
 
-		/* Set up the write data buffer. */
-		SPI_CONTROLLER_Write_One_Byte(OPCODE_READ);
+	snor_read_stop();
+	snor_addr_mode_end();
 
-		if (spi_chip_info->addr4b)
-			SPI_CONTROLLER_Write_One_Byte((physical_read_addr >> 24) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte((physical_read_addr >> 16) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte((physical_read_addr >> 8) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte(physical_read_addr & 0xff);
+	printf("Read 100%% [%llu] of [%llu] bytes      \n", len - remain_len, len);
+	timer_end();
 
-		unsigned int read_sz;
-		if((data_offset + remain_len) < transfer_sz)
-			read_sz = remain_len;
-		else
-			read_sz = transfer_sz;
+	return len;
+}
+
+/*
+ * Program one page: WRITE ENABLE, PAGE PROGRAM with its address and data,
+ * and the first status burst go out in one submission. The burst usually
+ * already shows the end of tPP, otherwise keep polling.
+ */
+static int snor_program_page(u8 *pkt, const u8 *data, u32 len, unsigned long long to)
+{
+	u8 cmd_wren[1] = { OPCODE_WREN };
+	u8 cmd_rdsr[1] = { OPCODE_RDSR };
+	u8 sr[SNOR_SR_BURST];
+	struct spi_transfer xfers[3] = {
+		{ sizeof(cmd_wren), 0, cmd_wren, NULL },
+		{ 0, 0, pkt, NULL },
+		{ sizeof(cmd_rdsr), sizeof(sr), cmd_rdsr, sr },
+	};
+	int i, n;
+
+	n = snor_cmd_addr(pkt, OPCODE_PP, to);
+	memcpy(pkt + n, data, len);
+	xfers[1].writecnt = n + len;
+
+	if (SPI_CONTROLLER_Send_Batch(xfers, 3))
+		return -1;
+
+	for (i = 0; i < SNOR_SR_BURST; i++)
+		if (!(sr[i] & (SR_WIP | SR_EPE)))
+			return 0;
+
+	return snor_wait_ready(3);
+}
+
+int snor_write_incremental = 0;
+
+/*
+ * Reflash [to, to + len) one erase unit at a time: read what the unit
+ * holds, leave it alone if it already matches, program it if the new data
+ * only clears bits, and erase and program it otherwise.
+ */
+static long long snor_write_diff(unsigned char *buf, unsigned long long to, unsigned long long len)
+{
+	u32 unit = snor_erase_unit(), page = spi_chip_info->page_size, off, span, i;
+	u32 skipped = 0, programmed = 0, erased = 0;
+	const struct snor_erase_type *et = NULL;
+	unsigned long long pos, done = 0;
+	u8 *old, *img, *pkt;
+	int t, ret = 0;
+
+	for (t = 0; t < SNOR_ERASE_TYPES; t++)
+		if (snor_erase_usable(&spi_chip_info->erase[t]) && spi_chip_info->erase[t].size == unit)
+			et = &spi_chip_info->erase[t];
+
+	if (!et) {
+		printf("%s: no erase command of %u bytes, the erase unit of this chip\n", __func__, unit);
+		return -1;
+	}
+
+	old = malloc(unit);
+	img = malloc(unit);
+	pkt = malloc(5 + page);
+	if (!old || !img || !pkt) {
+		printf("Malloc failed for write buffer.\n");
+		ret = -1;
+		goto out;
+	}
+
+	timer_start();
+	if (snor_wait_ready(2)) {
+		ret = -1;
+		goto out;
+	}
+
+	snor_write_enable();
+	snor_unprotect();
+	snor_wait_ready(3);
+
+	snor_addr_mode_begin();
 
-		if(SPI_CONTROLLER_Read_NByte(&buf[len - remain_len], read_sz, SPI_CONTROLLER_SPEED_SINGLE)) {
-			SPI_CONTROLLER_Chip_Select_High();
-			if (spi_chip_info->addr4b)
-				snor_4byte_mode(0);
-			len = -1;
+	for (pos = to - to % unit; pos < to + len; pos += unit) {
+		bool clear_only = true;
+
+		if (snor_read_start(pos)) {
+			ret = -1;
 			break;
 		}
+		ret = SPI_CONTROLLER_Read_NByte(old, unit, SPI_CONTROLLER_SPEED_SINGLE);
+		snor_read_stop();
+		if (ret)
+			break;
 
-		remain_len -= read_sz;
-		read_addr += read_sz;
-		//if ((read_addr & 0xffff) == 0) {
-			printf("\bRead %ld%% [%lu] of [%lu] bytes      ", 100 * (len - remain_len) / len, len - remain_len, len);
-			printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
-			fflush(stdout);
-		//}
+		/* the unit as it should be afterwards */
+		off = pos < to ? to - pos : 0;
+		span = min(unit - off, to + len - (pos + off));
+		memcpy(img, old, unit);
+		memcpy(img + off, buf + done, span);
+		done += span;
 
+		if (!memcmp(old, img, unit)) {
+			skipped++;
+			goto progress;
+		}
 
-		SPI_CONTROLLER_Chip_Select_High();
+		for (i = 0; i < unit && clear_only; i++)
+			clear_only = (old[i] & img[i]) == img[i];
+
+		if (clear_only)
+			programmed++;
+		else {
+			if (snor_erase_block(et, pos)) {
+				ret = -1;
+				break;
+			}
+			memset(old, 0xff, unit);
+			erased++;
+		}
 
-		if (spi_chip_info->addr4b)
-			snor_4byte_mode(0);
+		for (i = 0; i < unit; i += page) {
+			if (!memcmp(old + i, img + i, page))
+				continue;
+			if (snor_program_page(pkt, img + i, page, pos + i)) {
+				printf("%s: program failed at 0x%llx\n", __func__, pos + i);
+				ret = -1;
+				break;
+			}
+		}
+		if (ret)
+			break;
+
+progress:
+		printf("\bWritten %lld%% [%llu] of [%llu] bytes      ", 100 * done / len, done, len);
+		printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+		fflush(stdout);
 	}
-	printf("Read 100%% [%lu] of [%lu] bytes      \n", len - remain_len, len);
-	timer_end();
 
-	return len;
+	snor_addr_mode_end();
+	snor_write_disable();
+
+	if (!ret) {
+		printf("Written 100%% [%llu] of [%llu] bytes      \n", done, len);
+		printf("Sectors: %u unchanged, %u programmed, %u erased and programmed\n", skipped, programmed, erased);
+		timer_end();
+	}
+
+out:
+	free(old);
+	free(img);
+	free(pkt);
+	return ret ? -1 : len;
 }
 
-int snor_write(unsigned char *buf, unsigned long to, unsigned long len)
+long long snor_write(unsigned char *buf, unsigned long long to, unsigned long long len)
 {
 	u32 page_offset, page_size;
-	int rc = 0, retlen = 0;
-	unsigned long plen = len;
+	u8 *pkt;
+	long long retlen = 0;
+	unsigned long long plen = len;
 
-	snor_dbg("%s: to:%x len:%x \n", __func__, to, len);
+	snor_dbg("%s: to:%llx len:%llx \n", __func__, to, len);
 
 	/* sanity checks */
 	if (len == 0)
@@ -664,75 +1453,67 @@ int snor_write(unsigned char *buf, unsigned long to, unsigned long len)
 	if (to + len > spi_chip_info->sector_size * spi_chip_info->n_sectors)
 		return -1;
 
+	if (snor_write_incremental)
+		return snor_write_diff(buf, to, len);
+
+	/* opcode, address and one page of data */
+	pkt = malloc(5 + spi_chip_info->page_size);
+	if (!pkt)
+		return -1;
+
 	timer_start();
 	/* Wait until finished previous write command. */
 	if (snor_wait_ready(2)) {
+		free(pkt);
 		return -1;
 	}
 
+	/* once for the whole operation, the status register write needs WREN */
+	snor_write_enable();
+	snor_unprotect();
+	snor_wait_ready(3);
 
 	/* what page do we start with? */
-	page_offset = to % FLASH_PAGESIZE;
+	page_offset = to % spi_chip_info->page_size;
 
-	if (spi_chip_info->addr4b)
-		snor_4byte_mode(1);
+	snor_addr_mode_begin();
 
 	/* write everything in PAGESIZE chunks */
 	while (len > 0) {
-		page_size = min(len, FLASH_PAGESIZE - page_offset);
+		page_size = min(len, spi_chip_info->page_size - page_offset);
 		page_offset = 0;
-		/* write the next page to flash */
 
-		snor_wait_ready(3);
-		snor_write_enable();
-		snor_unprotect();
-
-		SPI_CONTROLLER_Chip_Select_Low();
-		/* Set up the opcode in the write buffer. */
-		SPI_CONTROLLER_Write_One_Byte(OPCODE_PP);
-
-		if (spi_chip_info->addr4b)
-			SPI_CONTROLLER_Write_One_Byte((to >> 24) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte((to >> 16) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte((to >> 8) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte(to & 0xff);
-
-		if(!SPI_CONTROLLER_Write_NByte(buf, page_size, SPI_CONTROLLER_SPEED_SINGLE))
-			rc = page_size;
-		else
-			rc = 1;
+		/* Programming 0xFF leaves flash as it is, so blank pages are not sent */
+		if (!mem_is_blank(buf, page_size)) {
+			if (snor_program_page(pkt, buf, page_size, to)) {
+				printf("%s: program failed at 0x%llx\n", __func__, to);
+				break;
+			}
+		}
 
-		SPI_CONTROLLER_Chip_Select_High();
+		snor_dbg("%s: to:%llx page_size:%x\n", __func__, to, page_size);
 
-		snor_dbg("%s: to:%x page_size:%x ret:%x\n", __func__, to, page_size, rc);
+		retlen += page_size;
+		len -= page_size;
+		to += page_size;
+		buf += page_size;
 
 		if ((retlen & 0xffff) == 0) {
-			printf("\bWritten %ld%% [%lu] of [%lu] bytes      ", 100 * (plen - len) / plen, plen - len, plen);
+			printf("\bWritten %lld%% [%llu] of [%llu] bytes      ", 100 * (plen - len) / plen, plen - len, plen);
 			printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 			fflush(stdout);
 		}
-
-		if (rc > 0) {
-			retlen += rc;
-			if (rc < page_size) {
-				printf("%s: rc:%x page_size:%x\n",
-						__func__, rc, page_size);
-				snor_write_disable();
-				return retlen - rc;
-			}
-		}
-
-		len -= page_size;
-		to += page_size;
-		buf += page_size;
 	}
 
-	if (spi_chip_info->addr4b)
-		snor_4byte_mode(0);
+	snor_addr_mode_end();
 
 	snor_write_disable();
+	free(pkt);
+
+	if (len)
+		return -1;
 
-	printf("Written 100%% [%ld] of [%ld] bytes      \n", plen - len, plen);
+	printf("Written 100%% [%llu] of [%llu] bytes      \n", plen - len, plen);
 	timer_end();
 
 	return retlen;